@@ -0,0 +1,288 @@
+#include "BenchmarkSuite.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include "Circuit.h"
+#include "FaultCampaign.h"
+#include "FaultList.h"
+#include "Parser.h"
+#include "RandomPatternGenerator.h"
+
+namespace {
+
+// One timed step of one netlist. 'rate' is the work done per second in 'unit'.
+struct Measurement {
+    std::string name;
+    double seconds;
+    double rate;
+    const char* unit;
+};
+
+// Runs 'step' the given number of times and returns the shortest time; 'prepare' runs untimed before each run.
+template <typename Prepare, typename Step>
+double timeFastest(size_t repeats, Prepare prepare, Step step) {
+    double fastest = 0.0;
+    for (size_t r = 0; r < std::max<size_t>(repeats, 1); ++r) {
+        prepare();
+        const auto start = std::chrono::steady_clock::now();
+        step();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (r == 0 || seconds < fastest) {
+            fastest = seconds;
+        }
+    }
+    return fastest;
+}
+
+void addMeasurement(std::vector<Measurement>& measurements, const std::string& name, double seconds, double work,
+                    const char* unit) {
+    measurements.push_back(Measurement{ name, seconds, seconds > 0.0 ? work / seconds : 0.0, unit });
+    std::cout << name << ": " << seconds * 1000.0 << " ms (" << measurements.back().rate / 1e6 << " M " << unit
+              << ")" << std::endl;
+}
+
+// Reads the measurement names and times of an earlier report; every measurement is on a line of its own.
+std::map<std::string, double> readBaseline(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Fehler beim Oeffnen der Vergleichsdatei: " << path << std::endl;
+        return baseline;
+    }
+    const std::string nameKey = "\"name\":\"";
+    const std::string secondsKey = "\"seconds\":";
+    std::string line;
+    while (std::getline(file, line)) {
+        const size_t name = line.find(nameKey);
+        const size_t seconds = line.find(secondsKey);
+        if (name == std::string::npos || seconds == std::string::npos) {
+            continue;
+        }
+        const size_t nameBegin = name + nameKey.size();
+        const size_t nameEnd = line.find('"', nameBegin);
+        baseline[line.substr(nameBegin, nameEnd - nameBegin)] = std::strtod(line.c_str() + seconds + secondsKey.size(),
+                                                                            nullptr);
+    }
+    return baseline;
+}
+
+bool parseSizeList(const char* text, std::vector<size_t>& sizes) {
+    sizes.clear();
+    std::stringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        const size_t size = std::strtoull(item.c_str(), nullptr, 10);
+        if (size == 0) {
+            return false;
+        }
+        sizes.push_back(size);
+    }
+    return !sizes.empty();
+}
+
+// Measures parsing, levelization, compilation, good simulation and the fault simulation of every compiled engine
+// on one generated netlist.
+void measureNetlist(const std::string& path, const std::string& label, const BenchmarkOptions& options,
+                    std::vector<Measurement>& measurements) {
+    std::unique_ptr<Circuit> circuit;
+    const double parseSeconds = timeFastest(options.repeats,
+        [&circuit] { circuit.reset(); circuit.reset(new Circuit()); },
+        [&circuit, &path] { Parser parser; parser.parse(path, *circuit); });
+    const double numGates = static_cast<double>(circuit->gates.size());
+    addMeasurement(measurements, label + "/parse", parseSeconds, numGates, "gates/s");
+
+    const double levelizeSeconds = timeFastest(options.repeats,
+        [&circuit] { circuit->levelizationValid = false; },
+        [&circuit] { circuit->getLevelizedGates(); });
+    addMeasurement(measurements, label + "/levelize", levelizeSeconds, numGates, "gates/s");
+
+    const double compileSeconds = timeFastest(options.repeats,
+        [&circuit] { circuit->compiledNetlistValid = false; },
+        [&circuit] { circuit->compileNetlist(); });
+    addMeasurement(measurements, label + "/compile", compileSeconds, numGates, "gates/s");
+
+    const CompiledNetlist& netlist = circuit->compiledNetlist;
+    const PatternKernels& kernels = *circuit->kernels;
+    RandomPatternGenerator generator;
+    generator.configure(circuit->inputs.size(), RandomPatternGenerator::PRNG, options.shape.seed);
+    const size_t words = kernels.blockWords;
+    std::vector<uint64_t> values(netlist.getValueArraySize(words));
+    const double goodSeconds = timeFastest(options.repeats, [] {}, [&] {
+        for (size_t base = 0; base < options.patterns; base += 64 * words) {
+            generator.loadBlock(netlist, values.data(), words, base);
+            netlist.simulate(values.data(), words, kernels);
+        }
+    });
+    addMeasurement(measurements, label + "/goodSim", goodSeconds, numGates * options.patterns, "gate-patterns/s");
+
+    // The stem faults of every non-output wire, as in runBigFaultedSimulation, sampled evenly.
+    std::vector<uint32_t> faultWires;
+    for (Wire* wire : circuit->getAllWiresButOutputs()) {
+        faultWires.push_back(wire->getId());
+    }
+    FaultList faultList;
+    faultList.build(netlist, faultWires, false);
+    const std::vector<StuckAtFault>& allFaults = faultList.getFaults();
+    std::vector<StuckAtFault> faults;
+    const size_t numFaults = std::min(allFaults.size(), options.maxFaults);
+    for (size_t i = 0; i < numFaults; ++i) {
+        faults.push_back(allFaults[i * allFaults.size() / numFaults]);
+    }
+
+    // The serial engine is the reference model that resimulates the whole circuit per fault and pattern; the
+    // campaigns replace it by the event-driven engine, so it is not measured.
+    const FaultSimulator::Engine engines[] = { FaultSimulator::EVENT_DRIVEN, FaultSimulator::PARALLEL_FAULT,
+                                               FaultSimulator::DEDUCTIVE };
+    const char* engineNames[] = { "serial", "eventDriven", "parallelFault", "deductive" };
+    size_t firstDetected = 0;
+    for (FaultSimulator::Engine engine : engines) {
+        size_t detected = 0;
+        const double faultSeconds = timeFastest(options.repeats, [] {}, [&] {
+            FaultCampaign campaign(netlist, kernels, engine);
+            campaign.setThreadCount(options.threads);
+            campaign.addFaults(faults);
+            campaign.run([&netlist, &generator](uint64_t* blockValues, size_t blockWords, size_t base, size_t) {
+                generator.loadBlock(netlist, blockValues, blockWords, base);
+            }, options.patterns);
+            detected = 0;
+            for (const FaultGrade& grade : campaign.getGrades()) {
+                detected += grade.firstDetection != FaultGrade::NotDetected;
+            }
+        });
+        addMeasurement(measurements, label + "/faultSim." + engineNames[engine], faultSeconds,
+                       static_cast<double>(faults.size()), "faults/s");
+        if (engine == engines[0]) {
+            firstDetected = detected;
+        } else if (detected != firstDetected) {
+            std::cerr << "Warning: " << engineNames[engine] << " detected " << detected << " of " << faults.size()
+                      << " faults, " << engineNames[engines[0]] << " " << firstDetected << std::endl;
+        }
+    }
+    std::cout << label << ": " << firstDetected << " of " << faults.size() << " sampled faults detected by "
+              << options.patterns << " patterns" << std::endl;
+}
+
+void writeReport(std::ostream& out, const BenchmarkOptions& options, const char* kernelsName,
+                 const std::vector<Measurement>& measurements) {
+    out << "{\n\"settings\":{\"kernels\":\"" << kernelsName << "\",\"threads\":" << options.threads
+        << ",\"patterns\":" << options.patterns << ",\"max_faults\":" << options.maxFaults
+        << ",\"repeats\":" << options.repeats << ",\"inputs\":" << options.shape.numInputs
+        << ",\"depth\":" << options.shape.depth << ",\"max_fanout\":" << options.shape.maxFanout
+        << ",\"locality\":" << options.shape.locality << ",\"seed\":" << options.shape.seed << "},\n";
+    out << "\"measurements\":[\n";
+    for (size_t i = 0; i < measurements.size(); ++i) {
+        const Measurement& m = measurements[i];
+        out << "{\"name\":\"" << m.name << "\",\"seconds\":" << m.seconds << ",\"rate\":" << m.rate
+            << ",\"unit\":\"" << m.unit << "\"}" << (i + 1 < measurements.size() ? "," : "") << "\n";
+    }
+    out << "]\n}\n";
+}
+
+}
+
+// Reads the options after argv[first]: --gates N[,N...] --inputs N --depth N --fanout N --locality X --seed N
+// --patterns N --faults N --threads N --repeats N --work DIR --output FILE --baseline FILE --tolerance X.
+bool parseBenchmarkOptions(int argc, char* argv[], int first, BenchmarkOptions& options) {
+    for (int a = first; a < argc; ++a) {
+        const std::string option = argv[a];
+        if (a + 1 >= argc) {
+            std::cerr << "Missing value for option " << option << std::endl;
+            return false;
+        }
+        const char* value = argv[++a];
+        const size_t number = std::strtoull(value, nullptr, 10);
+        if (option == "--gates") {
+            if (!parseSizeList(value, options.gateCounts)) {
+                std::cerr << "Invalid gate counts: " << value << std::endl;
+                return false;
+            }
+        } else if (option == "--inputs") {
+            options.shape.numInputs = number;
+        } else if (option == "--depth") {
+            options.shape.depth = number;
+        } else if (option == "--fanout") {
+            options.shape.maxFanout = number;
+        } else if (option == "--locality") {
+            options.shape.locality = std::strtod(value, nullptr);
+        } else if (option == "--seed") {
+            options.shape.seed = number;
+        } else if (option == "--patterns") {
+            options.patterns = number;
+        } else if (option == "--faults") {
+            options.maxFaults = number;
+        } else if (option == "--threads") {
+            options.threads = number;
+        } else if (option == "--repeats") {
+            options.repeats = number;
+        } else if (option == "--work") {
+            options.workDirectory = value;
+        } else if (option == "--output") {
+            options.outputFile = value;
+        } else if (option == "--baseline") {
+            options.baselineFile = value;
+        } else if (option == "--tolerance") {
+            options.tolerance = std::strtod(value, nullptr);
+        } else {
+            std::cerr << "Unknown option " << option << std::endl;
+            return false;
+        }
+    }
+    options.shape.numGates = options.gateCounts.front();
+    return true;
+}
+
+// Generates a netlist per gate count, measures it and prints the measurements as JSON (to the output file if one
+// is set). With a baseline every measurement is compared to the one of the same name there. Returns 1 if any
+// measurement regressed beyond the tolerance, 0 otherwise.
+int runBenchmarkSuite(const BenchmarkOptions& options) {
+    std::vector<Measurement> measurements;
+    for (size_t numGates : options.gateCounts) {
+        NetlistShape shape = options.shape;
+        shape.numGates = numGates;
+        const std::string label = "g" + std::to_string(numGates);
+        const std::string path = options.workDirectory + "/bench_" + label + "_s" + std::to_string(shape.seed) + ".v";
+        if (!writeRandomNetlist(path, shape)) {
+            return 1;
+        }
+        measureNetlist(path, label, options, measurements);
+        std::remove(path.c_str());
+    }
+
+    const char* kernelsName = selectPatternKernels().name;
+    writeReport(std::cout, options, kernelsName, measurements);
+    if (!options.outputFile.empty()) {
+        std::ofstream file(options.outputFile);
+        if (!file) {
+            std::cerr << "Fehler beim Schreiben der Berichtsdatei: " << options.outputFile << std::endl;
+        } else {
+            writeReport(file, options, kernelsName, measurements);
+        }
+    }
+    if (options.baselineFile.empty()) {
+        return 0;
+    }
+
+    const std::map<std::string, double> baseline = readBaseline(options.baselineFile);
+    size_t regressions = 0;
+    for (const Measurement& m : measurements) {
+        const auto entry = baseline.find(m.name);
+        if (entry == baseline.end() || entry->second <= 0.0) {
+            continue;
+        }
+        const double ratio = m.seconds / entry->second;
+        const bool regressed = ratio > 1.0 + options.tolerance;
+        regressions += regressed;
+        std::cout << m.name << ": " << ratio << "x the baseline time"
+                  << (regressed ? " REGRESSION" : ratio < 1.0 / (1.0 + options.tolerance) ? " (faster)" : "")
+                  << std::endl;
+    }
+    std::cout << regressions << " regressions against " << options.baselineFile << std::endl;
+    return regressions ? 1 : 0;
+}
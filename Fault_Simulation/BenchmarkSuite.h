@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "NetlistGenerator.h"
+
+// Settings of the benchmark suite; 'shape' is used for every size in 'gateCounts'.
+struct BenchmarkOptions {
+    std::vector<size_t> gateCounts = { 1000, 10000, 100000 };
+    NetlistShape shape;
+    size_t patterns = 1024;
+    // Larger fault lists are sampled evenly down to this many faults.
+    size_t maxFaults = 4096;
+    size_t threads = 1;
+    // Every measurement is repeated this often and the fastest run is reported.
+    size_t repeats = 3;
+    // Directory the generated netlists are written to; they are removed after their measurements.
+    std::string workDirectory = ".";
+    // JSON report of the run, and an earlier report to compare against; a measurement that is more than
+    // 'tolerance' slower than its baseline is a regression.
+    std::string outputFile;
+    std::string baselineFile;
+    double tolerance = 0.25;
+};
+
+bool parseBenchmarkOptions(int argc, char* argv[], int first, BenchmarkOptions& options);
+int runBenchmarkSuite(const BenchmarkOptions& options);
@@ -1,11 +1,25 @@
 ﻿#include "Circuit.h"
 #include <fstream>
 #include <iostream>
-#include <stack>
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
 #include "Parser.h"
+#include "ParallelFaultSimulator.h"
+#include "FaultList.h"
+#include "MappedFile.h"
+#include "NetlistCache.h"
+#include "ExhaustiveSweep.h"
+#include "RandomPatternGenerator.h"
+#include "Podem.h"
+#include "Instrumentation.h"
 
-Circuit::Circuit() {
-    // Constructor implementation (if needed)
+const size_t Circuit::MaxStoredInputs;
+
+Circuit::Circuit()
+    : kernels(&selectPatternKernels()) // Use the widest pattern kernels the host CPU supports.
+{
+    
 }
 
 Circuit::~Circuit() {
@@ -17,11 +31,70 @@ Circuit::~Circuit() {
 }
 
 void Circuit::loadFromFile(const std::string& filepath) {
+    INSTRUMENT_RUN("loadFromFile");
+    // An unchanged netlist is loaded from its binary cache instead of being parsed again.
+    // The cache is only used for an empty circuit, since it replaces the whole netlist.
+    const bool useCache = netlistCacheEnabled && inputs.empty() && outputs.empty() && internalWires.empty() && gates.empty();
+    uint64_t sourceHash = 0;
+    uint64_t sourceSize = 0;
+    if (useCache) {
+        INSTRUMENT_PHASE("loadCache");
+        const auto start = std::chrono::steady_clock::now();
+        MappedFile source;
+        if (source.open(filepath)) {
+            sourceHash = NetlistCache::hashContents(source.data(), source.size());
+            sourceSize = source.size();
+            if (NetlistCache::load(NetlistCache::getCachePath(filepath), sourceHash, sourceSize, *this)) {
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                std::clog << "Loaded " << filepath << " from its netlist cache in " << seconds * 1000.0 << " ms\n";
+                // The cache holds the netlist as written; the optimized form is compiled from it.
+                if (netlistOptimization != NetlistOptimizer::NO_OPTIMIZATION) {
+                    compiledNetlistValid = false;
+                    compileNetlist();
+                }
+                return;
+            }
+        }
+    }
+
     Parser parser;
-    parser.parse(filepath, *this);
+    {
+        INSTRUMENT_PHASE("parse");
+        parser.parse(filepath, *this);
+    }
+    if (parser.getParseSeconds() > 0.0) {
+        const double megabytes = parser.getBytesParsed() / (1024.0 * 1024.0);
+        std::clog << "Parsed " << filepath << ": " << megabytes << " MB in " << parser.getParseSeconds() * 1000.0
+                  << " ms (" << megabytes / parser.getParseSeconds() << " MB/s)\n";
+    }
+    // Flatten the netlist once, right after parsing, so that the simulations never have to rebuild it.
+    // The cache is written from the netlist as written, so an optimized netlist is compiled after saving it.
+    const bool saveCache = useCache && parser.getParseSeconds() > 0.0;
+    const NetlistOptimizer::Mode optimization = netlistOptimization;
+    if (saveCache) {
+        netlistOptimization = NetlistOptimizer::NO_OPTIMIZATION;
+    }
+    compileNetlist();
+    if (saveCache) {
+        {
+            INSTRUMENT_PHASE("saveCache");
+            NetlistCache::save(NetlistCache::getCachePath(filepath), sourceHash, sourceSize, *this);
+        }
+        netlistOptimization = optimization;
+        if (optimization != NetlistOptimizer::NO_OPTIMIZATION) {
+            compiledNetlistValid = false;
+            compileNetlist();
+        }
+    }
+}
+
+// Selects whether loadFromFile reads and writes the binary netlist cache (<netlist>.fsc); enabled by default.
+void Circuit::setNetlistCache(bool enabled) {
+    netlistCacheEnabled = enabled;
 }
 
 void Circuit::runAndPrintGoodSimulation() {
+    INSTRUMENT_RUN("printedGoodSimulation");
     auto results = runGoodSimulation();
     printGoodSimulationResultsToConsole(results);
     printGoodSimulationResults(results);
@@ -31,63 +104,94 @@ void Circuit::runAndPrintGoodSimulation() {
     //printBigGoodSimulationResultsToConsole(bigresults);
 }
 
-void Circuit::generateRandomInputs() {
-    const size_t numInputs = inputs.size();
-    srand(static_cast<unsigned int>(time(nullptr)));
+// Fills randomInputCombinations with the first 'count' patterns of the seeded random pattern generator
+// (see setRandomPatterns), so every run tests the same combinations.
+void Circuit::generateRandomInputs(size_t count) {
+    RandomPatternGenerator generator;
+    generator.configure(inputs.size(), randomPatternMode, randomSeed);
     randomInputCombinations.clear();
-
-    for (size_t i = 0; i < 3; ++i) {
-        std::vector<bool> currentInputs;
-        for (size_t j = 0; j < numInputs; ++j) {
-            bool inputValue = rand() % 2;
-            currentInputs.push_back(inputValue);
-        }
-        randomInputCombinations.push_back(currentInputs);
+    for (size_t i = 0; i < count; ++i) {
+        randomInputCombinations.push_back(generator.getPattern(i));
     }
 }
 
-std::vector<std::vector<bool>> Circuit::runBigGoodSimulation() {
+ResultStore Circuit::runBigGoodSimulation() {
     const size_t numInputs = inputs.size();
     const size_t numOutputs = outputs.size();
-    std::vector<std::vector<bool>> simulationResults;
-    buildGraph();
-    std::stack<Gate*> sortedGates = topologicalSort();
+    ResultStore simulationResults;
+    simulationResults.allocate(randomInputCombinations.size(), numOutputs);
+    if (patternParallel) {
+        compileNetlist();
+        const size_t words = kernels->blockWords;
+        const size_t blockPatterns = 64 * words;
+        patternValues.assign(compiledNetlist.getValueArraySize(words), 0);
+        for (size_t base = 0; base < randomInputCombinations.size(); base += blockPatterns) {
+            const size_t numPatterns = std::min(blockPatterns, randomInputCombinations.size() - base);
+            loadPatternBlock(patternValues.data(), words, base, numPatterns, &randomInputCombinations);
+            compiledNetlist.simulate(patternValues.data(), words, *kernels);
+            collectPatternBlockOutputs(base, numPatterns, simulationResults);
+        }
+        return simulationResults;
+    }
+
+    const std::vector<Gate*>& sortedGates = getLevelizedGates();
 
-    for (const auto& currentInputs : randomInputCombinations) {
+    for (size_t i = 0; i < randomInputCombinations.size(); ++i) {
         for (size_t j = 0; j < numInputs; ++j) {
-            inputs[j]->setValue(currentInputs[j]);
+            inputs[j]->setValue(randomInputCombinations[i][j]);
         }
-        std::stack<Gate*> tempSortedGates = sortedGates;
-        while (!tempSortedGates.empty()) {
-            Gate* currentGate = tempSortedGates.top();
+        for (Gate* currentGate : sortedGates) {
             currentGate->computeOutput();
-            tempSortedGates.pop();
         }
-        std::vector<bool> currentOutput;
+        INSTRUMENT_COUNT(GATE_EVALUATIONS, sortedGates.size());
         for (size_t k = 0; k < numOutputs; ++k) {
-            currentOutput.push_back(outputs[k]->getValue());
+            simulationResults.set(i, k, outputs[k]->getValue());
         }
-        simulationResults.push_back(currentOutput);
     }
     return simulationResults;
 }
 
 // Runs a comprehensive simulation of the circuit for all possible input combinations and collects the results.
-std::vector<std::vector<bool>> Circuit::runGoodSimulation() {
+ResultStore Circuit::runGoodSimulation() {
+    INSTRUMENT_RUN("goodSimulation");
     // Determine the total number of input wires and output wires in the circuit.
     const size_t numInputs = inputs.size();
     const size_t numOutputs = outputs.size();
+    // The complete result table holds one bit per output and input combination; beyond a few billion
+    // combinations it cannot be kept, and runExhaustiveSweep streams per-chunk summaries instead.
+    if (numInputs > MaxStoredInputs) {
+        std::cerr << "Error: " << numInputs << " inputs are too many for a complete result table; "
+                  << "use runExhaustiveSweep instead." << std::endl;
+        return ResultStore();
+    }
     // Calculate the total number of input combinations possible based on the number of input wires.
-    // This uses bitwise left shift to compute 2^numInputs.
-    const size_t numCombinations = 1 << numInputs;
-    // Initialize a container to store the simulation results for each input combination.
-    std::vector<std::vector<bool>> simulationResults;
-    // Prepare the circuit for simulation by building a graph representation of all gates and their connections.
-    buildGraph();
+    // This uses a 64-bit left shift to compute 2^numInputs.
+    const size_t numCombinations = size_t(1) << numInputs;
+    // Initialize a packed store for the simulation results, one bit per output and input combination.
+    // With a result file set, the store is kept in that memory-mapped file instead of the heap.
+    ResultStore simulationResults;
+    simulationResults.allocate(numCombinations, numOutputs, resultFile);
+    INSTRUMENT_COUNT(PATTERNS, numCombinations);
+
+    // In pattern-parallel mode a whole block of input combinations (64 per word) is simulated per pass
+    // over the compiled netlist, which is built once and needs no graph rebuilding or allocation per pattern.
+    if (patternParallel) {
+        compileNetlist();
+        const size_t words = kernels->blockWords;
+        const size_t blockPatterns = 64 * words;
+        patternValues.assign(compiledNetlist.getValueArraySize(words), 0);
+        for (size_t base = 0; base < numCombinations; base += blockPatterns) {
+            const size_t numPatterns = std::min(blockPatterns, numCombinations - base);
+            loadPatternBlock(patternValues.data(), words, base, numPatterns, nullptr);
+            compiledNetlist.simulate(patternValues.data(), words, *kernels);
+            collectPatternBlockOutputs(base, numPatterns, simulationResults);
+        }
+        return simulationResults;
+    }
 
-    // Order the gates in a sequence that respects their dependencies using topological sorting.
-    // This ensures that each gate is computed only after all its inputs have been resolved.
-    std::stack<Gate*> sortedGates = topologicalSort();
+    // Order the gates by logic level, so that each gate is computed only after all its inputs have been resolved.
+    // The order is cached and only recomputed when the netlist changes.
+    const std::vector<Gate*>& sortedGates = getLevelizedGates();
 
     // Iterate over every possible combination of input values.
     for (size_t i = 0; i < numCombinations; ++i) {
@@ -97,163 +201,969 @@ std::vector<std::vector<bool>> Circuit::runGoodSimulation() {
             bool inputValue = (i >> j) & 1; // Extract the j-th bit of 'i' to use as the input value.
             inputs[j]->setValue(inputValue); // Set the value of the j-th input wire.
         }
-        // Create a temporary copy of the sorted gates for this simulation iteration.
-        // This is necessary because we will be modifying the stack by popping elements.
-        std::stack<Gate*> tempSortedGates = sortedGates;
-        // Compute the outputs by iterating through the gates in topologically sorted order.
-        while (!tempSortedGates.empty()) {
-            Gate* currentGate = tempSortedGates.top(); // Get the next gate to compute.
+        // Compute the outputs by iterating through the gates in level order.
+        for (Gate* currentGate : sortedGates) {
             currentGate->computeOutput(); // Compute the output of this gate based on its inputs.
-            tempSortedGates.pop(); // Remove this gate from the temporary stack.
         }
-        // Collect the output values for the current input combination.
-        std::vector<bool> currentOutput;
+        INSTRUMENT_COUNT(GATE_EVALUATIONS, sortedGates.size());
+        // Store the output values for the current input combination in the simulation results.
         for (size_t k = 0; k < numOutputs; ++k) {
-            currentOutput.push_back(outputs[k]->getValue()); // Get the value of the k-th output wire.
+            simulationResults.set(i, k, outputs[k]->getValue()); // Get the value of the k-th output wire.
         }
-        // Add the collected output values to the simulation results.
-        simulationResults.push_back(currentOutput);
     }
     // Return the collected simulation results.
     return simulationResults;
 }
 
-// Constructs a directed graph representing the circuit's gates and their dependencies.
-void Circuit::buildGraph() {
-    // First, clear any existing graph data to prepare for building a new graph.
-    adjList.clear();
-    // Iterate through each gate in the circuit to establish its relationships within the graph.
-    // This loop examines every gate to determine how gates are interconnected through their input and output wires.
-    for (auto& gate : gates) {
-        // Check if the current gate produces an output.
-        // A gate must have an output wire to influence other gates within the circuit.
-        if (gate->getOutput() != nullptr) {
-            // For each gate that has an output, examine all other gates to identify which ones are dependent on this output.
-            // A dependent gate is one that uses the current gate's output as an input to its own operation.
-            for (auto& dependentGate : gates) {
-                // Check if the dependent gate uses the current gate's output as either of its inputs.
-                if (dependentGate->getInput1() == gate->getOutput() || 
-                    dependentGate->getInput2() == gate->getOutput()) {
-                    // If the dependent gate is found, it means the current gate directly influences the dependent gate.
-                    // Therefore, add an edge in the graph from the current gate to the dependent gate to represent this relationship.
-                    adjList[gate].push_back(dependentGate);
+// Orders the gates by logic level with Kahn's algorithm, using the driver/fanout index kept on the wires.
+// Runs in time linear in the number of gates and pins, without recursion, and caches the result until the netlist changes.
+const std::vector<Gate*>& Circuit::getLevelizedGates() {
+    if (levelizationValid) {
+        return levelizedGates;
+    }
+    INSTRUMENT_PHASE("levelize");
+
+    // Count for every gate how many of its inputs are still waiting for their driving gate.
+    std::unordered_map<const Gate*, int> pendingInputs;
+    pendingInputs.reserve(gates.size());
+    std::vector<Gate*> ready;
+    for (Gate* gate : gates) {
+        int pending = 0;
+        if (gate->getInput1() && gate->getInput1()->getDriver()) {
+            ++pending;
+        }
+        if (gate->getInput2() && gate->getInput2()->getDriver()) {
+            ++pending;
+        }
+        pendingInputs[gate] = pending;
+        gate->setLevel(0);
+        if (pending == 0) {
+            ready.push_back(gate);
+        }
+    }
+
+    // Release gates in topological order; a gate's level is one more than that of its deepest driving gate.
+    std::vector<Gate*> topological;
+    topological.reserve(gates.size());
+    int maxLevel = 0;
+    for (size_t next = 0; next < ready.size(); ++next) {
+        Gate* gate = ready[next];
+        topological.push_back(gate);
+        maxLevel = std::max(maxLevel, gate->getLevel());
+        for (Gate* dependentGate : gate->getOutput()->getFanout()) {
+            dependentGate->setLevel(std::max(dependentGate->getLevel(), gate->getLevel() + 1));
+            if (--pendingInputs[dependentGate] == 0) {
+                ready.push_back(dependentGate);
+            }
+        }
+    }
+    if (topological.size() != gates.size()) {
+        std::cerr << "Error: The netlist contains a combinational loop, " << gates.size() - topological.size()
+                  << " gates could not be levelized." << std::endl;
+    }
+
+    // Bucket the gates by level and, within a level, by opcode (a stable counting sort). The order stays
+    // topological, and gates of the same kind form runs that the compiled netlist evaluates with one kernel each.
+    const size_t numBuckets = (size_t(maxLevel) + 1) * Gate::NumOpcodes;
+    std::vector<size_t> bucketStart(numBuckets + 1, 0);
+    for (Gate* gate : topological) {
+        ++bucketStart[gate->getLevel() * Gate::NumOpcodes + gate->getOpcode() + 1];
+    }
+    for (size_t bucket = 0; bucket < numBuckets; ++bucket) {
+        bucketStart[bucket + 1] += bucketStart[bucket];
+    }
+    levelizedGates.assign(topological.size(), nullptr);
+    for (Gate* gate : topological) {
+        levelizedGates[bucketStart[gate->getLevel() * Gate::NumOpcodes + gate->getOpcode()]++] = gate;
+    }
+    levelizationValid = true;
+    return levelizedGates;
+}
+
+// Marks the cached levelization and compiled netlist as stale after the netlist has changed.
+void Circuit::invalidateNetlist() {
+    levelizationValid = false;
+    compiledNetlistValid = false;
+}
+
+// Builds the flat netlist form from the gates and wires, unless it is still up to date. With a netlist
+// optimization selected (see setNetlistOptimization) the optimized gate list is compiled instead.
+// Faults that are currently injected into wires are carried over into the compiled form.
+// 'faultGrading' is set by the runs that inject or grade faults: FUNCTIONAL rewrites keep the outputs but not the
+// fault sites, so those runs compile the EQUIVALENT form, whose removed wires map onto equivalent faults.
+void Circuit::compileNetlist(bool faultGrading) {
+    NetlistOptimizer::Mode optimization = netlistOptimization;
+    // Branch faults sit on the pins of the compiled gates, so they are graded on the netlist as written.
+    if (branchFaults) {
+        optimization = NetlistOptimizer::NO_OPTIMIZATION;
+    } else if (faultGrading && optimization == NetlistOptimizer::FUNCTIONAL) {
+        optimization = NetlistOptimizer::EQUIVALENT;
+    }
+    if (compiledNetlistValid && compiledOptimization == optimization) {
+        return;
+    }
+    INSTRUMENT_PHASE("compileNetlist");
+    const std::vector<Wire*> allWires = getAllWires();
+    if (optimization == NetlistOptimizer::NO_OPTIMIZATION) {
+        netlistOptimizer.clear();
+        compiledNetlist.build(allWires, inputs, outputs, getLevelizedGates());
+    } else {
+        {
+            INSTRUMENT_PHASE("optimizeNetlist");
+            netlistOptimizer.optimize(allWires, inputs, outputs, getLevelizedGates(), optimization);
+        }
+        compiledNetlist.build(allWires, inputs, netlistOptimizer.getOutputs(), netlistOptimizer.getGates());
+        std::clog << "Optimized netlist: " << gates.size() << " -> " << netlistOptimizer.getGates().size()
+                  << " gates (" << netlistOptimizer.getRemovedDead() << " dead, "
+                  << netlistOptimizer.getRemovedBuffers() << " buffers/inverters, "
+                  << netlistOptimizer.getRemovedConstants() << " constant, " << netlistOptimizer.getMergedGates()
+                  << " merged)\n";
+    }
+    for (Wire* wire : allWires) {
+        StuckAtFault fault;
+        if (wire->hasFault() && netlistOptimizer.resolveFault(StuckAtFault{ wire->getId(), wire->getFaultValue() },
+                                                              fault)) {
+            compiledNetlist.forceWire(fault.wire, fault.value);
+        }
+    }
+    compiledOptimization = optimization;
+    compiledNetlistValid = true;
+}
+
+// Simulates the exhaustive input combinations of the chunks firstChunk .. endChunk-1 (all chunks by default) on
+// the configured number of threads without storing the responses. Every chunk's summary is appended to
+// "exhaustive-summary.txt" as soon as its turn in chunk order comes, so an interrupted sweep is resumed by
+// passing the chunk after the last line in that file. The totals of the run are printed to the console.
+void Circuit::runExhaustiveSweep(uint64_t firstChunk, uint64_t endChunk) {
+    INSTRUMENT_RUN("exhaustiveSweep");
+    compileNetlist();
+    ExhaustiveSweep sweep(compiledNetlist, *kernels);
+    sweep.setThreadCount(faultThreads);
+    std::ofstream outFile("exhaustive-summary.txt", std::ios::app);
+    const auto start = std::chrono::steady_clock::now();
+    const bool completed = sweep.run(firstChunk, endChunk, [&outFile](const SweepChunkSummary& summary) {
+        outFile << "chunk " << summary.chunk << " patterns " << summary.firstPattern << "-"
+                << summary.firstPattern + summary.numPatterns - 1 << " signature " << std::hex << summary.signature
+                << std::dec << " ones ";
+        for (size_t k = 0; k < summary.onesPerOutput.size(); ++k) {
+            outFile << summary.onesPerOutput[k] << (k < summary.onesPerOutput.size() - 1 ? "," : "\n");
+        }
+        outFile.flush();
+    });
+    outFile.close();
+    if (!completed) {
+        return;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Exhaustive sweep: " << sweep.getPatternsSimulated() << " of " << sweep.getNumPatterns()
+              << " input combinations (chunks " << firstChunk << " to "
+              << std::min(endChunk, sweep.getNumChunks()) << " of " << sweep.getNumChunks() << ") in "
+              << seconds << " s\n";
+    for (size_t k = 0; k < outputs.size(); ++k) {
+        std::cout << outputs[k]->getName() << " is 1 for " << sweep.getOnesPerOutput()[k] << " combinations\n";
+    }
+}
+
+// Copies the output words of the simulated pattern block starting at pattern 'base' (a multiple of 64) into the
+// result store; lanes beyond 'numPatterns' are cleared.
+void Circuit::collectPatternBlockOutputs(size_t base, size_t numPatterns, ResultStore& results) {
+    const size_t numOutputs = outputs.size();
+    const size_t words = kernels->blockWords;
+    for (size_t w = 0; w < words && 64 * w < numPatterns; ++w) {
+        uint64_t* stored = results.getWord(base / 64 + w);
+        const uint64_t valid = validLaneMask(numPatterns, w);
+        for (size_t k = 0; k < numOutputs; ++k) {
+            stored[k] = patternValues[compiledNetlist.outputIds[k] * words + w] & valid;
+        }
+    }
+}
+
+// Sets the primary input words of one pattern block in a dense value array. Pattern 'base + l' goes to lane l,
+// taken from 'patterns' or, if that is null, the exhaustive combination with index 'base + l'.
+void Circuit::loadPatternBlock(uint64_t* values, size_t words, size_t base, size_t numPatterns,
+                               const std::vector<std::vector<bool>>* patterns) {
+    for (size_t j = 0; j < inputs.size(); ++j) {
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t word = 0;
+            if (!patterns) {
+                word = exhaustiveInputWord(base + 64 * w, j);
+            } else {
+                // Pack the given input combinations into the lanes of the word.
+                for (size_t lane = 0; lane < 64 && w * 64 + lane < numPatterns; ++lane) {
+                    word |= uint64_t((*patterns)[base + w * 64 + lane][j]) << lane;
                 }
             }
+            compiledNetlist.setInputWord(values, words, j, w, word);
         }
     }
-    // By the end of this process, `adjList` contains a complete representation of the circuit as a directed graph.
-    // Each gate (node) is connected to the gates (nodes) that depend on its output, allowing for analysis of the circuit's computational dependencies, such as through topological sorting.
 }
 
-// This function visits gates in a depth-first manner and records the order of traversal. / Utility function for performing depth-first search (DFS) as part of a topological sort.
-void Circuit::topologicalSortUtil(Gate* gate, std::map<Gate*, bool>& visited, std::stack<Gate*>& stack) {
-    // Mark the current gate as visited to prevent revisiting and to handle cyclic dependencies.
-    visited[gate] = true;
-    // Recursively explore all gates that are directly dependent on the current gate.
-    // This is to ensure that all dependencies of a gate are processed before the gate itself.
-    for (auto& dependentGate : adjList[gate]) {
-        // Check if the dependent gate has not been visited yet.
-        if (!visited[dependentGate]) {
-            // If the dependent gate is unvisited, recursively call this function to visit it.
-            // This step ensures that we dive deeper into the dependency chain before processing the current gate.
-            topologicalSortUtil(dependentGate, visited, stack);
+// Loads test cubes base .. base+numPatterns-1 (0, 1 or Podem::Unassigned per input) into the input rails of a
+// dual-rail pattern block; unassigned inputs and the lanes past the last cube are X.
+void Circuit::loadCubeBlock(uint64_t* values, size_t words, size_t base, size_t numPatterns,
+                            const std::vector<std::vector<int8_t>>& cubes) {
+    for (size_t j = 0; j < inputs.size(); ++j) {
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t ones = 0;
+            uint64_t zeros = 0;
+            for (size_t lane = 0; lane < 64 && w * 64 + lane < numPatterns; ++lane) {
+                const int8_t value = cubes[base + w * 64 + lane][j];
+                ones |= uint64_t(value == 1) << lane;
+                zeros |= uint64_t(value == 0) << lane;
+            }
+            compiledNetlist.setInputRails(values, words, j, w, ones, zeros);
         }
     }
-    // Once all dependencies of the current gate have been processed (due to recursion reaching the base case), push the current gate onto the stack.
-    // This action effectively places the gate in a post-order sequence, where a gate appears in the sequence only after all gates dependent on it have been included.
-    stack.push(gate);
-    // The use of a stack here is critical for topological sorting: it reverses the order of processing, ensuring that gates are processed from least dependent to most dependent.
-    // This is essential for computing gate outputs in a logical sequence during simulation.
 }
 
-// Conducts a topological sort on the circuit's gates to determine an order in which they can be evaluated so that each gate is computed only after all its dependencies.
-std::stack<Gate*> Circuit::topologicalSort() {
-    std::stack<Gate*> stack; // A stack to hold the gates in topologically sorted order.
-    std::map<Gate*, bool> visited; // A map to track whether each gate has been visited during the sort.
-    // Initialize all gates as not visited by setting their corresponding values in the 'visited' map to false.
-    // This preparation step is crucial for the depth-first search (DFS) algorithm, ensuring that each gate is visited exactly once during the sorting process.
-    for (auto& gate : gates) {
-        visited[gate] = false;
+// Grades the stuck-at faults against the first 'numPatterns' patterns (from 'patterns' or exhaustive) with the
+// selected compiled engine. Each fault is dropped once it reached the detection limit; its grade holds the index of
+// the first detecting pattern (FaultGrade::NotDetected if there is none).
+std::vector<FaultGrade> Circuit::gradeStuckAtFaults(const std::vector<StuckAtFault>& faults, size_t numPatterns,
+                                                    const std::vector<std::vector<bool>>* patterns) {
+    compileNetlist(true);
+    FaultCampaign campaign(compiledNetlist, *kernels, faultEngine);
+    campaign.setDetectionLimit(detectionLimit);
+    campaign.setThreadCount(faultThreads);
+    campaign.setCriticalPathTracing(criticalPathTracing);
+    campaign.addFaults(faults);
+    campaign.run([this, patterns](uint64_t* values, size_t words, size_t base, size_t count) {
+        loadPatternBlock(values, words, base, count, patterns);
+    }, numPatterns);
+    return campaign.getGrades();
+}
+
+// Grades every stuck-at fault of the non-output wires (collapsed and with branch faults as configured) against
+// seeded random patterns that the generator writes straight into the pattern blocks of the campaign. The campaign
+// ends when the pattern budget is used up, every fault is detected, or the coverage has not grown for the
+// coverage patience. With ATPG enabled, PODEM then targets the faults left undetected, and with compaction the
+// detecting patterns are compacted to a smaller test set for the same faults, which is written to
+// "test_patterns.txt". Prints the undetected and redundant
+// faults and the coverage, and in LFSR mode the MISR signature of the good responses to the random patterns.
+void Circuit::runRandomFaultCampaign() {
+    INSTRUMENT_RUN("randomFaultCampaign");
+    compileNetlist(true);
+    std::vector<uint32_t> faultWires;
+    for (Wire* wire : getAllWiresButOutputs()) {
+        faultWires.push_back(wire->getId());
+    }
+    FaultList faultList;
+    faultList.build(compiledNetlist, faultWires, branchFaults, &netlistOptimizer);
+    faultList.collapse(faultCollapsing);
+    if (faultCollapsing != FaultList::NO_COLLAPSING) {
+        std::cout << "Collapsed " << faultList.getFaults().size() << " faults to "
+                  << faultList.getRepresentatives().size() << " representatives\n";
+    }
+
+    RandomPatternGenerator generator;
+    generator.configure(inputs.size(), randomPatternMode, randomSeed);
+    // The serial engine has no pattern blocks; it is replaced by the event-driven one.
+    FaultCampaign campaign(compiledNetlist, *kernels,
+                           faultEngine == FaultSimulator::SERIAL ? FaultSimulator::EVENT_DRIVEN : faultEngine);
+    campaign.setDetectionLimit(detectionLimit);
+    campaign.setThreadCount(faultThreads);
+    campaign.setCriticalPathTracing(criticalPathTracing);
+    campaign.setCoveragePatience(coveragePatience);
+    campaign.addFaults(faultList.getRepresentatives());
+    campaign.run([this, &generator](uint64_t* values, size_t words, size_t base, size_t) {
+        generator.loadBlock(compiledNetlist, values, words, base);
+    }, static_cast<size_t>(patternBudget));
+    const uint64_t randomPatterns = campaign.getPatternsApplied();
+    std::vector<FaultGrade> representativeGrades = campaign.getGrades();
+    std::vector<uint8_t> representativeRedundant(representativeGrades.size(), 0);
+    size_t aborted = 0;
+    std::vector<std::vector<bool>> atpgPatterns;
+    if (atpgEnabled) {
+        atpgPatterns = generateAtpgPatterns(faultList.getRepresentatives(), representativeGrades, generator,
+                                            randomPatterns, representativeRedundant, aborted);
+    }
+    if (compactionEnabled) {
+        writeTestPatterns(compactTestSet(faultList.getRepresentatives(), representativeGrades, generator,
+                                         randomPatterns, atpgPatterns));
     }
-    // Iterate over all gates in the circuit to ensure that each gate is processed, even if the circuit contains disconnected components or if not all gates are reachable from a single starting point.
-    for (auto& gate : gates) {
-        // If the current gate has not yet been visited, initiate a depth-first search from it.
-        // This call will explore the gate, along with all gates that are dependent on it, marking them as visited, and placing them onto the stack in an order such
-        // that a gate is only placed on the stack after all gates that depend on its output have been placed on the stack.
-        if (!visited[gate]) {
-            topologicalSortUtil(gate, visited, stack);
+    const std::vector<FaultGrade> grades = faultList.expandGrades(representativeGrades);
+    const std::vector<uint8_t> redundant = faultList.expandRedundant(representativeRedundant);
+
+    const std::vector<StuckAtFault>& faults = faultList.getFaults();
+    std::vector<Wire*> wiresById(compiledNetlist.getNumWires(), nullptr);
+    for (Wire* wire : getAllWires()) {
+        wiresById[wire->getId()] = wire;
+    }
+    size_t detected = 0;
+    size_t numRedundant = 0;
+    for (size_t i = 0; i < faults.size(); ++i) {
+        if (grades[i].firstDetection != FaultGrade::NotDetected) {
+            ++detected;
+        } else if (redundant[i]) {
+            ++numRedundant;
+            std::cout << "Fault is redundant for " << getFaultSiteName(faults[i], wiresById)
+                      << " stuck-at-" << faults[i].value << "\n";
+        } else {
+            std::cout << "Fault was undetected for " << getFaultSiteName(faults[i], wiresById)
+                      << " stuck-at-" << faults[i].value << "\n";
         }
     }
-    // Return the stack containing the gates in topologically sorted order.
-    // The stack's top will have the gate that should be computed last, while the stack's bottom will have the gate that should be computed first.
-    // This order ensures that when gates are popped from the stack and processed, each gate is processed only after all its input dependencies have been resolved.
-    return stack;
+    std::cout << "Random patterns (" << (randomPatternMode == RandomPatternGenerator::LFSR ? "LFSR" : "PRNG")
+              << ", seed " << randomSeed << "): " << randomPatterns << " patterns";
+    if (atpgEnabled) {
+        std::cout << ", PODEM: " << atpgPatterns.size() << " patterns (" << numRedundant << " faults redundant, "
+                  << aborted << " aborted)";
+    }
+    std::cout << " detected " << detected << " of " << faults.size() << " faults ("
+              << (faults.empty() ? 100.0 : 100.0 * detected / faults.size()) << "% coverage";
+    if (atpgEnabled) {
+        // Test coverage leaves out the faults no pattern can detect.
+        const size_t testable = faults.size() - numRedundant;
+        std::cout << ", " << (testable == 0 ? 100.0 : 100.0 * detected / testable) << "% test coverage";
+    }
+    std::cout << ")\n";
+    printDetectionSummary(grades);
+    if (randomPatternMode == RandomPatternGenerator::LFSR) {
+        std::cout << "MISR signature: " << std::hex << computeResponseSignature(generator, randomPatterns)
+                  << std::dec << "\n";
+    }
 }
 
-// Writes the results of the circuit simulation to a text file.
-void Circuit::printGoodSimulationResults(const std::vector<std::vector<bool>>& results) {
-    // Determine the number of input wires to calculate the total number of possible input combinations.
-    const size_t numInputs = inputs.size();
-    // Calculate the total number of input combinations using bitwise left shift, effectively computing 2^numInputs.
-    const size_t numCombinations = 1 << numInputs;
-    // Create an output file stream to write the simulation results into a file named "simulation_results.txt".
-    std::ofstream outFile("simulation_results.txt"); // Open file for writing
-    
-    // Iterate through each possible input combination to document the corresponding output values.
-    for (size_t i = 0; i < numCombinations; ++i) {
-        // Begin each line by listing the input combination being considered.
-        outFile << "inputs: ";
-        // Iterate through each input wire to display the current combination's value for that input.
-        for (size_t j = 0; j < numInputs; ++j) {
-            // Calculate the value of the j-th input for the i-th combination by right-shifting i by j positions
-            // and isolating the least significant bit (& 1). This effectively extracts the j-th bit of i.
-            outFile << ((i >> j) & 1) << (j < numInputs - 1 ? "," : " ");
-            // This produces a sequence of 0s and 1s representing the current input state, separated by commas.
+// Grades the slow-to-rise and slow-to-fall transition faults of every non-output wire (and of the branches if
+// configured) against random pattern pairs. The first patterns of the pairs come from the configured generator,
+// the second ones from a generator with the next seed; the circuits are combinational, so each pair is applied
+// as it is rather than launched from a captured state. Collapsing does not apply: stuck-at equivalences do not
+// carry over to transition faults. Budget, coverage patience, detection limit and threads are those of the
+// random stuck-at campaign. Prints the undetected faults and the coverage.
+void Circuit::runTransitionFaultCampaign() {
+    INSTRUMENT_RUN("transitionFaultCampaign");
+    compileNetlist(true);
+    std::vector<uint32_t> faultWires;
+    for (Wire* wire : getAllWiresButOutputs()) {
+        faultWires.push_back(wire->getId());
+    }
+    FaultList faultList;
+    faultList.build(compiledNetlist, faultWires, branchFaults, &netlistOptimizer);
+
+    RandomPatternGenerator initialGenerator;
+    RandomPatternGenerator finalGenerator;
+    initialGenerator.configure(inputs.size(), randomPatternMode, randomSeed);
+    finalGenerator.configure(inputs.size(), randomPatternMode, randomSeed + 1);
+    FaultCampaign campaign(compiledNetlist, *kernels,
+                           faultEngine == FaultSimulator::SERIAL ? FaultSimulator::EVENT_DRIVEN : faultEngine);
+    campaign.setDetectionLimit(detectionLimit);
+    campaign.setThreadCount(faultThreads);
+    campaign.setCriticalPathTracing(criticalPathTracing);
+    campaign.setCoveragePatience(coveragePatience);
+    // Stuck-at-0 stands for slow-to-rise and stuck-at-1 for slow-to-fall.
+    campaign.addFaults(faultList.getRepresentatives());
+    campaign.setInitialPatterns([this, &initialGenerator](uint64_t* values, size_t words, size_t base, size_t) {
+        initialGenerator.loadBlock(compiledNetlist, values, words, base);
+    });
+    campaign.run([this, &finalGenerator](uint64_t* values, size_t words, size_t base, size_t) {
+        finalGenerator.loadBlock(compiledNetlist, values, words, base);
+    }, static_cast<size_t>(patternBudget));
+    const std::vector<FaultGrade> grades = faultList.expandGrades(campaign.getGrades());
+
+    const std::vector<StuckAtFault>& faults = faultList.getFaults();
+    std::vector<Wire*> wiresById(compiledNetlist.getNumWires(), nullptr);
+    for (Wire* wire : getAllWires()) {
+        wiresById[wire->getId()] = wire;
+    }
+    size_t detected = 0;
+    for (size_t i = 0; i < faults.size(); ++i) {
+        if (grades[i].firstDetection != FaultGrade::NotDetected) {
+            ++detected;
+        } else {
+            std::cout << "Fault was undetected for " << getFaultSiteName(faults[i], wiresById)
+                      << (faults[i].value ? " slow-to-fall" : " slow-to-rise") << "\n";
         }
-        // After listing the inputs, document the corresponding outputs generated by the circuit.
-        outFile << "gives outputs: ";
-        // Iterate through the output values stored in the results vector for the current input combination.
-        for (size_t k = 0; k < results[i].size(); ++k) {
-            // Write each output value, followed by a comma unless it's the last value, in which case end the line.
-            outFile << results[i][k] << (k < results[i].size() - 1 ? "," : "\n");
+    }
+    std::cout << "Transition pairs (" << (randomPatternMode == RandomPatternGenerator::LFSR ? "LFSR" : "PRNG")
+              << ", seed " << randomSeed << "): " << campaign.getPatternsApplied() << " pairs detected " << detected
+              << " of " << faults.size() << " transition faults ("
+              << (faults.empty() ? 100.0 : 100.0 * detected / faults.size()) << "% coverage)\n";
+    printDetectionSummary(grades);
+}
+
+// Grades every stuck-at fault of the non-output wires (collapsed and with branch faults as configured) against
+// partially specified test cubes in three-valued simulation: an unassigned input is X rather than 0, and a
+// fault only counts as detected where an output is a definite 0 against a definite 1, whatever the fill.
+// Prints the undetected faults and the coverage.
+void Circuit::runCubeFaultSimulation(const std::vector<std::vector<int8_t>>& cubes) {
+    INSTRUMENT_RUN("cubeFaultSimulation");
+    compileNetlist(true);
+    for (const std::vector<int8_t>& cube : cubes) {
+        if (cube.size() != inputs.size()) {
+            std::cerr << "Error: A test cube has " << cube.size() << " values for " << inputs.size() << " inputs.\n";
+            return;
         }
-        // This loop results in a line for each input combination, showing the input values and their resulting outputs.
     }
-    // After documenting all input-output combinations, close the file to ensure data is written and resources are released.
-    outFile.close();
+    std::vector<uint32_t> faultWires;
+    for (Wire* wire : getAllWiresButOutputs()) {
+        faultWires.push_back(wire->getId());
+    }
+    FaultList faultList;
+    faultList.build(compiledNetlist, faultWires, branchFaults, &netlistOptimizer);
+    faultList.collapse(faultCollapsing);
+
+    FaultCampaign campaign(compiledNetlist, *kernels, FaultSimulator::EVENT_DRIVEN);
+    campaign.setThreeValued(true);
+    campaign.setDetectionLimit(detectionLimit);
+    campaign.setThreadCount(faultThreads);
+    campaign.addFaults(faultList.getRepresentatives());
+    campaign.run([this, &cubes](uint64_t* values, size_t words, size_t base, size_t count) {
+        loadCubeBlock(values, words, base, count, cubes);
+    }, cubes.size());
+    const std::vector<FaultGrade> grades = faultList.expandGrades(campaign.getGrades());
+
+    const std::vector<StuckAtFault>& faults = faultList.getFaults();
+    std::vector<Wire*> wiresById(compiledNetlist.getNumWires(), nullptr);
+    for (Wire* wire : getAllWires()) {
+        wiresById[wire->getId()] = wire;
+    }
+    size_t detected = 0;
+    for (size_t i = 0; i < faults.size(); ++i) {
+        if (grades[i].firstDetection != FaultGrade::NotDetected) {
+            ++detected;
+        } else {
+            std::cout << "Fault was undetected for " << getFaultSiteName(faults[i], wiresById)
+                      << " stuck-at-" << faults[i].value << "\n";
+        }
+    }
+    size_t unassigned = 0;
+    for (const std::vector<int8_t>& cube : cubes) {
+        unassigned += std::count(cube.begin(), cube.end(), Podem::Unassigned);
+    }
+    std::cout << "Test cubes: " << cubes.size() << " cubes ("
+              << (cubes.empty() || inputs.empty() ? 0.0 : 100.0 * unassigned / (cubes.size() * inputs.size()))
+              << "% of the inputs X) detected " << detected << " of " << faults.size() << " faults ("
+              << (faults.empty() ? 100.0 : 100.0 * detected / faults.size()) << "% coverage)\n";
+    printDetectionSummary(grades);
+}
+
+// Targets the representatives the random patterns left undetected with PODEM. The test cubes are collected in
+// batches of 64, with cube merging each new cube is merged into the first compatible cube of its batch. Every
+// cube of a batch is filled with the generator's next random pattern. Before PODEM takes on the next target, the
+// target is fault-simulated against the batch so far and skipped if some pattern of the batch already detects it.
+// The full batch is then fault-simulated against all representatives still undetected, so a new pattern drops
+// every fault it catches; their grades point at the pattern, numbered on from 'firstPattern'. Flags the
+// representatives proven redundant, counts the aborted ones and returns the generated patterns. ATPG patterns
+// count as a single detection, also for N-detect campaigns.
+std::vector<std::vector<bool>> Circuit::generateAtpgPatterns(const std::vector<StuckAtFault>& faults,
+                                                             std::vector<FaultGrade>& grades,
+                                                             RandomPatternGenerator& generator, uint64_t firstPattern,
+                                                             std::vector<uint8_t>& redundant, size_t& aborted) {
+    INSTRUMENT_PHASE("atpg");
+    std::vector<std::vector<bool>> patterns;
+    std::vector<uint32_t> undetected;
+    for (size_t i = 0; i < faults.size(); ++i) {
+        if (grades[i].firstDetection == FaultGrade::NotDetected) {
+            undetected.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    Podem podem(compiledNetlist);
+    podem.setBacktrackLimit(backtrackLimit);
+    FaultSimulator simulator(compiledNetlist, *kernels, threeValued);
+    const size_t words = simulator.getBlockWords();
+    std::vector<uint64_t> detectedLanes(words);
+    std::vector<int8_t> cube;
+
+    // A batch occupies the 64 lanes of the first block word; a fault detected by one batch is not targeted again.
+    // Lane i holds the cube filled with pattern 'batchFirst + i' of the generator.
+    std::vector<std::vector<int8_t>> batchCubes;
+    std::vector<std::vector<bool>> batchPatterns;
+    std::vector<uint32_t> batchTargets;
+    std::vector<uint32_t> batchSkipped;
+    // Loads the batch into the good values and simulates it. In three-valued mode the unfilled cubes are
+    // simulated, so only detections that hold for every fill are credited.
+    auto simulateBatch = [&]() {
+        if (threeValued) {
+            loadCubeBlock(simulator.getGoodValues(), words, 0, batchCubes.size(), batchCubes);
+        }
+        for (size_t j = 0; j < inputs.size() && !threeValued; ++j) {
+            uint64_t word = 0;
+            for (size_t lane = 0; lane < batchPatterns.size(); ++lane) {
+                word |= uint64_t(batchPatterns[lane][j]) << lane;
+            }
+            for (size_t w = 0; w < words; ++w) {
+                compiledNetlist.setInputWord(simulator.getGoodValues(), words, j, w, w == 0 ? word : 0);
+            }
+        }
+        simulator.simulateGood();
+    };
+    // A fault skipped because the batch detected it is targeted once more if a later merge changed the fill of
+    // the detecting lane and the batch lost it; the second time it is not skipped.
+    std::vector<uint8_t> retargeted(faults.size(), 0);
+    size_t target = 0;
+    while (target < undetected.size()) {
+        const uint64_t batchFirst = firstPattern + patterns.size();
+        batchCubes.clear();
+        batchPatterns.clear();
+        batchTargets.clear();
+        batchSkipped.clear();
+        bool batchSimulated = true;
+        for (; target < undetected.size() && batchCubes.size() < 64; ++target) {
+            const uint32_t fault = undetected[target];
+            if (grades[fault].firstDetection != FaultGrade::NotDetected || redundant[fault]) {
+                continue;
+            }
+            if (!batchCubes.empty() && !retargeted[fault]) {
+                if (!batchSimulated) {
+                    simulateBatch();
+                    batchSimulated = true;
+                }
+                if (simulator.simulateFault(faults[fault], detectedLanes.data())
+                    && (detectedLanes[0] & validLaneMask(batchCubes.size(), 0))) {
+                    batchSkipped.push_back(fault);
+                    continue;
+                }
+            }
+            const Podem::Result result = podem.generateTest(faults[fault], cube);
+            if (result == Podem::REDUNDANT) {
+                redundant[fault] = 1;
+                continue;
+            }
+            if (result == Podem::ABORTED) {
+                ++aborted;
+                continue;
+            }
+            batchTargets.push_back(fault);
+            size_t lane = 0;
+            while (lane < batchCubes.size() && !(cubeMerging && Podem::mergeCubes(batchCubes[lane], cube))) {
+                ++lane;
+            }
+            if (lane == batchCubes.size()) {
+                batchCubes.push_back(cube);
+                batchPatterns.push_back(generator.getPattern(batchFirst + lane));
+            }
+            for (size_t j = 0; j < batchCubes[lane].size(); ++j) {
+                if (batchCubes[lane][j] != Podem::Unassigned) {
+                    batchPatterns[lane][j] = batchCubes[lane][j] != 0;
+                }
+            }
+            batchSimulated = false;
+        }
+        if (batchCubes.empty()) {
+            continue;
+        }
+        patterns.insert(patterns.end(), batchPatterns.begin(), batchPatterns.end());
+
+        // Grade the batch against every fault still undetected.
+        if (!batchSimulated) {
+            simulateBatch();
+        }
+        const uint64_t validLanes = validLaneMask(batchCubes.size(), 0);
+        for (uint32_t fault : undetected) {
+            FaultGrade& grade = grades[fault];
+            if (grade.firstDetection == FaultGrade::NotDetected && !redundant[fault]
+                && simulator.simulateFault(faults[fault], detectedLanes.data()) && (detectedLanes[0] & validLanes)) {
+                grade.firstDetection = batchFirst + lowestSetLane(detectedLanes[0] & validLanes);
+                grade.detections = 1;
+            }
+        }
+        for (uint32_t fault : batchTargets) {
+            if (grades[fault].firstDetection == FaultGrade::NotDetected) {
+                // The cube must detect its target; count a disagreement with the fault simulator as aborted.
+                ++aborted;
+            }
+        }
+        for (uint32_t fault : batchSkipped) {
+            if (grades[fault].firstDetection == FaultGrade::NotDetected) {
+                retargeted[fault] = 1;
+                undetected.push_back(fault);
+            }
+        }
+    }
+    return patterns;
+}
+
+// Builds the test set of the campaign from the random patterns that first detected a representative and the ATPG
+// patterns, compacts it and checks with a fresh grading of the compacted set that no representative lost its
+// detection. Prints the pattern counts before and after and returns the compacted test set.
+std::vector<std::vector<bool>> Circuit::compactTestSet(const std::vector<StuckAtFault>& faults,
+                                                       const std::vector<FaultGrade>& grades,
+                                                       RandomPatternGenerator& generator, uint64_t randomPatterns,
+                                                       const std::vector<std::vector<bool>>& atpgPatterns) {
+    INSTRUMENT_PHASE("compaction");
+    std::vector<uint8_t> usefulRandom(static_cast<size_t>(randomPatterns), 0);
+    size_t detected = 0;
+    for (const FaultGrade& grade : grades) {
+        if (grade.firstDetection == FaultGrade::NotDetected) {
+            continue;
+        }
+        ++detected;
+        if (grade.firstDetection < randomPatterns) {
+            usefulRandom[static_cast<size_t>(grade.firstDetection)] = 1;
+        }
+    }
+    std::vector<std::vector<bool>> testSet;
+    for (size_t i = 0; i < usefulRandom.size(); ++i) {
+        if (usefulRandom[i]) {
+            testSet.push_back(generator.getPattern(i));
+        }
+    }
+    const size_t numRandom = testSet.size();
+    testSet.insert(testSet.end(), atpgPatterns.begin(), atpgPatterns.end());
+    const std::vector<std::vector<bool>> compacted = compactPatterns(faults, testSet);
+
+    size_t stillDetected = 0;
+    for (const FaultGrade& grade : gradeStuckAtFaults(faults, compacted.size(), &compacted)) {
+        if (grade.firstDetection != FaultGrade::NotDetected) {
+            ++stillDetected;
+        }
+    }
+    std::cout << "Compaction: " << (randomPatterns + atpgPatterns.size()) << " patterns applied, " << testSet.size()
+              << " detecting (" << numRandom << " random, " << atpgPatterns.size() << " PODEM), compacted to "
+              << compacted.size() << " patterns\n";
+    if (stillDetected != detected) {
+        std::cerr << "Error: The compacted test set detects " << stillDetected << " of the " << detected
+                  << " detected representatives.\n";
+    }
+    return compacted;
+}
+
+// Writes a test set to "test_patterns.txt": a comment line naming the primary inputs, then one line per pattern
+// with the value of every input in that order.
+void Circuit::writeTestPatterns(const std::vector<std::vector<bool>>& patterns) {
+    std::ofstream outFile("test_patterns.txt", std::ios::trunc);
+    if (!outFile) {
+        std::cerr << "Fehler beim Schreiben der Musterdatei: test_patterns.txt" << std::endl;
+        return;
+    }
+    outFile << "#";
+    for (const Wire* input : inputs) {
+        outFile << " " << input->getName();
+    }
+    outFile << "\n";
+    std::string line;
+    for (const std::vector<bool>& pattern : patterns) {
+        line.assign(pattern.size(), '0');
+        for (size_t j = 0; j < pattern.size(); ++j) {
+            if (pattern[j]) {
+                line[j] = '1';
+            }
+        }
+        outFile << line << "\n";
+    }
+    if (!outFile) {
+        std::cerr << "Fehler beim Schreiben der Musterdatei: test_patterns.txt" << std::endl;
+    }
+}
+
+// Static compaction of a test set for the faults: fault-simulates the patterns with fault dropping, first in
+// reverse order, and keeps only the patterns that detected some fault for the first time. Every fault stays
+// detected by the pattern that first caught it. The passes alternate direction on the surviving patterns until
+// one drops nothing; the kept patterns are returned in their original order.
+std::vector<std::vector<bool>> Circuit::compactPatterns(const std::vector<StuckAtFault>& faults,
+                                                        std::vector<std::vector<bool>> patterns) {
+    compileNetlist(true);
+    bool reversed = false;
+    for (;;) {
+        std::reverse(patterns.begin(), patterns.end());
+        reversed = !reversed;
+        FaultCampaign campaign(compiledNetlist, *kernels,
+                               faultEngine == FaultSimulator::SERIAL ? FaultSimulator::EVENT_DRIVEN : faultEngine);
+        campaign.setThreadCount(faultThreads);
+        campaign.setCriticalPathTracing(criticalPathTracing);
+        campaign.addFaults(faults);
+        campaign.run([this, &patterns](uint64_t* values, size_t words, size_t base, size_t count) {
+            loadPatternBlock(values, words, base, count, &patterns);
+        }, patterns.size());
+
+        std::vector<uint8_t> keep(patterns.size(), 0);
+        for (const FaultGrade& grade : campaign.getGrades()) {
+            if (grade.firstDetection != FaultGrade::NotDetected) {
+                keep[grade.firstDetection] = 1;
+            }
+        }
+        std::vector<std::vector<bool>> kept;
+        for (size_t i = 0; i < patterns.size(); ++i) {
+            if (keep[i]) {
+                kept.push_back(std::move(patterns[i]));
+            }
+        }
+        const bool dropped = kept.size() < patterns.size();
+        patterns.swap(kept);
+        if (!dropped) {
+            break;
+        }
+    }
+    if (reversed) {
+        std::reverse(patterns.begin(), patterns.end());
+    }
+    return patterns;
+}
+
+// Compacts the good responses to the first 'numPatterns' patterns of 'generator' into a MISR signature.
+uint64_t Circuit::computeResponseSignature(RandomPatternGenerator& generator, uint64_t numPatterns) {
+    compileNetlist();
+    const size_t words = kernels->blockWords;
+    const uint64_t blockPatterns = 64 * words;
+    patternValues.assign(compiledNetlist.getValueArraySize(words), 0);
+    std::vector<uint64_t> outputWords(outputs.size());
+    Misr misr;
+    for (uint64_t base = 0; base < numPatterns; base += blockPatterns) {
+        const size_t patternsInBlock = static_cast<size_t>(std::min(blockPatterns, numPatterns - base));
+        generator.loadBlock(compiledNetlist, patternValues.data(), words, base);
+        compiledNetlist.simulate(patternValues.data(), words, *kernels);
+        for (size_t w = 0; w < words && 64 * w < patternsInBlock; ++w) {
+            for (size_t k = 0; k < outputs.size(); ++k) {
+                outputWords[k] = patternValues[compiledNetlist.outputIds[k] * words + w];
+            }
+            misr.compact(outputWords.data(), outputWords.size(), validLaneMask(patternsInBlock, w));
+        }
+    }
+    return misr.getSignature();
+}
+
+// Collapses the fault list with the selected collapsing mode, grades only its representatives and expands the
+// grades back onto every listed fault.
+std::vector<FaultGrade> Circuit::gradeFaultList(FaultList& faultList, size_t numPatterns,
+                                                const std::vector<std::vector<bool>>* patterns) {
+    faultList.collapse(faultCollapsing);
+    if (faultCollapsing != FaultList::NO_COLLAPSING) {
+        std::cout << "Collapsed " << faultList.getFaults().size() << " faults to "
+                  << faultList.getRepresentatives().size() << " representatives\n";
+    }
+    return faultList.expandGrades(gradeStuckAtFaults(faultList.getRepresentatives(), numPatterns, patterns));
+}
+
+// Name of a fault site as printed in the reports: the wire for a stem fault, the wire and the gate it feeds for a branch.
+// 'wiresById' maps wire ids to wires.
+std::string Circuit::getFaultSiteName(const StuckAtFault& fault, const std::vector<Wire*>& wiresById) {
+    std::string site = wiresById[fault.wire]->getName();
+    if (fault.isBranch()) {
+        site += " -> " + wiresById[compiledNetlist.gateOutput[fault.gate]]->getName();
+    }
+    return site;
+}
+
+// Simulates the currently injected fault and compares its outputs with 'goodResults' as they are produced,
+// pattern by pattern or word by word (XOR against the packed good responses), without materializing the faulty
+// responses. Returns the first detecting pattern, or FaultGrade::NotDetected; simulation stops as soon as the
+// detection limit is reached.
+uint64_t Circuit::simulateUntilDetected(const ResultStore& goodResults,
+                                        const std::vector<std::vector<bool>>* patterns) {
+    const size_t numPatterns = goodResults.getNumPatterns();
+    const size_t numOutputs = outputs.size();
+    uint64_t firstPattern = FaultGrade::NotDetected;
+    uint64_t detections = 0;
+
+    if (patternParallel) {
+        compileNetlist(true);
+        const size_t words = kernels->blockWords;
+        const size_t blockPatterns = 64 * words;
+        patternValues.assign(compiledNetlist.getValueArraySize(words), 0);
+        std::vector<uint64_t> outputWords(numOutputs);
+        for (size_t base = 0; base < numPatterns && detections < detectionLimit; base += blockPatterns) {
+            const size_t patternsInBlock = std::min(blockPatterns, numPatterns - base);
+            loadPatternBlock(patternValues.data(), words, base, patternsInBlock, patterns);
+            compiledNetlist.simulate(patternValues.data(), words, *kernels);
+            for (size_t w = 0; w < words && 64 * w < patternsInBlock && detections < detectionLimit; ++w) {
+                for (size_t k = 0; k < numOutputs; ++k) {
+                    outputWords[k] = patternValues[compiledNetlist.outputIds[k] * words + w];
+                }
+                const uint64_t detected = goodResults.compareWord(base / 64 + w, outputWords.data());
+                if (detected) {
+                    firstPattern = std::min<uint64_t>(firstPattern, base + 64 * w + lowestSetLane(detected));
+                    detections += countSetLanes(detected);
+                }
+            }
+        }
+        return firstPattern;
+    }
+
+    const std::vector<Gate*>& sortedGates = getLevelizedGates();
+    for (size_t i = 0; i < numPatterns && detections < detectionLimit; ++i) {
+        for (size_t j = 0; j < inputs.size(); ++j) {
+            inputs[j]->setValue(patterns ? bool((*patterns)[i][j]) : bool((i >> j) & 1));
+        }
+        for (Gate* currentGate : sortedGates) {
+            currentGate->computeOutput();
+        }
+        INSTRUMENT_COUNT(GATE_EVALUATIONS, sortedGates.size());
+        for (size_t k = 0; k < numOutputs; ++k) {
+            if (outputs[k]->getValue() != goodResults.get(i, k)) {
+                firstPattern = std::min<uint64_t>(firstPattern, i);
+                ++detections;
+                break;
+            }
+        }
+    }
+    return firstPattern;
+}
+
+// For N-detect campaigns, prints how many faults reached the detection limit.
+void Circuit::printDetectionSummary(const std::vector<FaultGrade>& grades) {
+    if (detectionLimit <= 1) {
+        return;
+    }
+    size_t reached = 0;
+    for (const FaultGrade& grade : grades) {
+        if (grade.detections >= detectionLimit) {
+            ++reached;
+        }
+    }
+    std::cout << reached << " of " << grades.size() << " faults detected at least " << detectionLimit << " times\n";
+}
+
+// Selects the random pattern generator of generateRandomInputs and runRandomFaultCampaign and its seed.
+void Circuit::setRandomPatterns(RandomPatternGenerator::Mode mode, uint64_t seed) {
+    randomPatternMode = mode;
+    randomSeed = seed;
+}
+
+// Selects whether runRandomFaultCampaign targets the faults its random patterns leave undetected with PODEM.
+void Circuit::setAtpg(bool enabled) {
+    atpgEnabled = enabled;
+}
+
+// Sets how many backtracks PODEM may take per fault before giving it up as aborted.
+void Circuit::setBacktrackLimit(size_t limit) {
+    backtrackLimit = limit;
+}
+
+// Selects whether runRandomFaultCampaign compacts its test set (the detecting random patterns and the PODEM patterns)
+// and writes it to "test_patterns.txt".
+void Circuit::setCompaction(bool enabled) {
+    compactionEnabled = enabled;
+}
+
+// Selects whether compatible PODEM test cubes are merged before they are filled with random values.
+void Circuit::setCubeMerging(bool enabled) {
+    cubeMerging = enabled;
+}
+
+// Selects whether the PODEM batches of runRandomFaultCampaign are graded as unfilled cubes in three-valued
+// simulation, crediting only the detections that do not depend on the random fill.
+void Circuit::setThreeValued(bool enabled) {
+    threeValued = enabled;
+}
+
+// Selects whether the two-valued event-driven fault campaigns simulate only the fanout-free region stems and
+// resolve the faults inside the regions by critical path tracing.
+void Circuit::setCriticalPathTracing(bool enabled) {
+    criticalPathTracing = enabled;
+}
+
+// Sets the largest number of random patterns runRandomFaultCampaign applies.
+void Circuit::setPatternBudget(uint64_t patterns) {
+    patternBudget = patterns;
+}
+
+// Ends runRandomFaultCampaign once this many consecutive patterns detected no new fault; 0 always uses the
+// whole pattern budget.
+void Circuit::setCoveragePatience(uint64_t patterns) {
+    coveragePatience = patterns;
+}
+
+// Keeps the good simulation results of runGoodSimulation in a memory-mapped file at 'path' instead of the heap,
+// for exhaustive sweeps whose responses do not fit into memory. An empty path switches back to the heap.
+void Circuit::setResultFile(const std::string& path) {
+    resultFile = path;
+}
+
+// Sets how many detecting patterns a fault needs before it is dropped from the campaign (N-detect).
+// The default of 1 drops every fault at its first detection.
+void Circuit::setDetectionLimit(uint64_t limit) {
+    detectionLimit = std::max<uint64_t>(limit, 1);
+}
+
+// Selects how runFaultedSimulation collapses its fault list before simulation. Collapsing only applies to the
+// compiled engines; the report still lists every fault.
+void Circuit::setFaultCollapsing(FaultList::Collapsing mode) {
+    faultCollapsing = mode;
+}
+
+// Selects whether runFaultedSimulation also grades the branch faults of wires that fan out to several gates.
+// Branch faults need a compiled engine and are ignored by SERIAL.
+void Circuit::setBranchFaults(bool enabled) {
+    branchFaults = enabled;
+    // The netlist optimization is skipped while branch faults are graded (see compileNetlist).
+    compiledNetlistValid = false;
+}
+
+// Selects the optimization applied to the netlist before it is compiled for the pattern-parallel and compiled
+// engines (see NetlistOptimizer). The circuit's gates are left as they are, and faults on removed wires are still
+// reported by their own names. Faults are graded on the EQUIVALENT form when FUNCTIONAL is selected (see
+// compileNetlist). Ignored while branch faults are enabled.
+void Circuit::setNetlistOptimization(NetlistOptimizer::Mode mode) {
+    netlistOptimization = mode;
+    compiledNetlistValid = false;
+}
+
+// Sets how many threads the compiled engines use to grade faults and runExhaustiveSweep uses to simulate chunks;
+// 0 uses every hardware thread. The report is the same for every thread count.
+void Circuit::setThreadCount(size_t threads) {
+    faultThreads = threads;
+}
+
+// Sends the fault reports of runFaultedSimulation and runBigFaultedSimulation to a file in the given format instead
+// of the console; an empty path restores the console. The detection summary stays on the console.
+void Circuit::setFaultReport(const std::string& path, ReportWriter::Format format) {
+    faultReportFile = path;
+    faultReportFormat = format;
+}
+
+// Appends a JSON performance report (phase times, counters and peak memory) to a file after every run; an empty
+// path turns the instrumentation off again.
+void Circuit::setRunReport(const std::string& path) {
+    Instrumentation::setReportFile(path);
+}
+
+// Selects the engine runFaultedSimulation and runBigFaultedSimulation use. SERIAL resimulates the whole circuit
+// per fault; the compiled engines produce the same report. DEDUCTIVE suits few patterns over large fault lists.
+void Circuit::setFaultEngine(FaultSimulator::Engine engine) {
+    faultEngine = engine;
+}
+
+// Selects whether the simulations evaluate one input combination per pass (false) or a whole pattern block at once (true).
+// Both modes produce identical results.
+void Circuit::setPatternParallel(bool enabled) {
+    patternParallel = enabled;
+}
+
+// Overrides the kernel set chosen by CPU dispatch, e.g. to compare ISA levels. Unsupported levels fall back to scalar.
+void Circuit::setPatternKernels(PatternKernels::IsaLevel isa) {
+    kernels = isIsaSupported(isa) ? &getPatternKernels(isa) : &getPatternKernels(PatternKernels::SCALAR);
+}
+
+// Writes the results of the circuit simulation to a text file.
+void Circuit::printGoodSimulationResults(const ResultStore& results) {
+    INSTRUMENT_PHASE("writeResults");
+    // The file "simulation_results.txt" is written through a report sink, which formats the lines on its own thread
+    // and writes them in large blocks instead of streaming every value.
+    ReportWriter report;
+    if (!report.open("simulation_results.txt", ReportWriter::TEXT)) {
+        return;
+    }
+    writeGoodResponses(results, report);
+    // Closing the sink writes the remaining lines and releases the file.
+    report.close();
 }
 
 // Prints the results of the circuit simulation to the console.
-void Circuit::printGoodSimulationResultsToConsole(const std::vector<std::vector<bool>>& results) {
-    // Determine the number of input wires to calculate the total number of possible input combinations.
-    const size_t numInputs = inputs.size();
-    // Calculate the total number of input combinations using bitwise left shift, effectively computing 2^numInputs.
-    const size_t numCombinations = 1 << numInputs;
-    
-    // Iterate through each possible input combination to document the corresponding output values.
+void Circuit::printGoodSimulationResultsToConsole(const ResultStore& results) {
+    INSTRUMENT_PHASE("writeResults");
+    ReportWriter report;
+    report.open(std::string(), ReportWriter::TEXT);
+    writeGoodResponses(results, report);
+    report.close();
+}
+
+// Queues one line per input combination: the combination's input values (the bits of its index) and the outputs
+// the results hold for it.
+void Circuit::writeGoodResponses(const ResultStore& results, ReportWriter& report) {
+    // The results hold every input combination, 2^numInputs of them.
+    const size_t numCombinations = results.getNumPatterns();
+    std::vector<bool> outputValues(results.getNumOutputs());
     for (size_t i = 0; i < numCombinations; ++i) {
-        // Begin each line by listing the input combination being considered.
-        std::cout << "inputs: ";
-        // Iterate through each input wire to display the current combination's value for that input.
-        for (size_t j = 0; j < numInputs; ++j) {
-            // Calculate the value of the j-th input for the i-th combination by right-shifting i by j positions
-            // and isolating the least significant bit (& 1). This effectively extracts the j-th bit of i.
-            std::cout << ((i >> j) & 1) << (j < numInputs - 1 ? "," : " ");
-            // This produces a sequence of 0s and 1s representing the current input state, separated by commas.
+        for (size_t k = 0; k < outputValues.size(); ++k) {
+            outputValues[k] = results.get(i, k);
         }
-        // After listing the inputs, document the corresponding outputs generated by the circuit.
-        std::cout << "gives outputs: ";
-        // Iterate through the output values stored in the results vector for the current input combination.
-        for (size_t k = 0; k < results[i].size(); ++k) {
-            // Write each output value, followed by a comma unless it's the last value, in which case end the line.
-            std::cout << results[i][k] << (k < results[i].size() - 1 ? "," : "\n");
-        }
-        // This loop results in a line for each input combination, showing the input values and their resulting outputs.
+        report.writeGoodResponse(i, inputs.size(), outputValues);
     }
 }
 
-void Circuit::printBigGoodSimulationResultsToConsole(const std::vector<std::vector<bool>>& results) {
-    if (randomInputCombinations.size() != results.size()) {
+void Circuit::printBigGoodSimulationResultsToConsole(const ResultStore& results) {
+    if (randomInputCombinations.size() != results.getNumPatterns()) {
         std::cerr << "Error: The number of input combinations and results does not match." << std::endl;
         return;
     }
@@ -264,14 +1174,56 @@ void Circuit::printBigGoodSimulationResultsToConsole(const std::vector<std::vect
             std::cout << randomInputCombinations[i][j] << (j < randomInputCombinations[i].size() - 1 ? "," : " ");
         }
         std::cout << "gives outputs: ";
-        for (size_t k = 0; k < results[i].size(); ++k) {
-            std::cout << results[i][k] << (k < results[i].size() - 1 ? "," : "\n");
+        for (size_t k = 0; k < results.getNumOutputs(); ++k) {
+            std::cout << results.get(i, k) << (k < results.getNumOutputs() - 1 ? "," : "\n");
         }
     }
 }
 
 // Conducts a fault simulation for the entire circuit, testing for stuck-at-0 and stuck-at-1 faults on all wires except outputs.
 void Circuit::runFaultedSimulation() {
+    INSTRUMENT_RUN("faultedSimulation");
+    // Every input combination is applied, which is only feasible for as many inputs as runGoodSimulation can store.
+    if (inputs.size() > MaxStoredInputs) {
+        std::cerr << "Error: " << inputs.size() << " inputs are too many to apply every input combination; "
+                  << "use runRandomFaultCampaign instead." << std::endl;
+        return;
+    }
+    // With a compiled engine all faults are graded in one campaign first and reported in the same order afterwards.
+    openFaultReport();
+    if (faultEngine != FaultSimulator::SERIAL) {
+        std::vector<uint32_t> faultWires;
+        for (Wire* wire : getAllWiresButOutputs()) {
+            faultWires.push_back(wire->getId());
+        }
+        compileNetlist(true);
+        FaultList faultList;
+        faultList.build(compiledNetlist, faultWires, branchFaults, &netlistOptimizer);
+        const size_t numCombinations = size_t(1) << inputs.size();
+        std::vector<FaultGrade> grades = gradeFaultList(faultList, numCombinations, nullptr);
+        // Faults come in stuck-at-0/stuck-at-1 pairs per site (a wire's stem, then its branches).
+        const std::vector<StuckAtFault>& faults = faultList.getFaults();
+        std::vector<Wire*> wiresById(compiledNetlist.getNumWires(), nullptr);
+        for (Wire* wire : getAllWires()) {
+            wiresById[wire->getId()] = wire;
+        }
+        INSTRUMENT_PHASE("writeReport");
+        for (size_t i = 0; i < faults.size(); i += 2) {
+            const std::string site = getFaultSiteName(faults[i], wiresById);
+            for (int faultType = 0; faultType <= 1; ++faultType) {
+                printFaultDetectionToConsole(site, faultType, grades[i + faultType].firstDetection);
+            }
+            for (int faultType = 0; faultType <= 1; ++faultType) {
+                if (grades[i + faultType].firstDetection == FaultGrade::NotDetected) {
+                    faultReport.writeUndetectedFault(site, faultType);
+                }
+            }
+        }
+        faultReport.close();
+        printDetectionSummary(grades);
+        return;
+    }
+
     // First, run a simulation of the circuit without any faults to establish a baseline of correct behavior.
     auto goodResults = runGoodSimulation();
 
@@ -285,13 +1237,12 @@ void Circuit::runFaultedSimulation() {
         for (int faultType = 0; faultType <= 1; ++faultType) {
             // Inject a fault into the current wire, where 'faultType' determines the nature of the fault.
             injectFault(wire, faultType);
-            // Run the simulation again with the fault injected to observe the circuit's behavior under faulty conditions.
-            std::vector<std::vector<bool>> faultedResults = runGoodSimulation();
-            // Compare the results of the faulted simulation with the results of the good simulation to determine if the fault was detected.
-            // A fault is considered detected if the output of the circuit with the fault differs from the output of the circuit without faults.
-            
-            //faultDetected[faultType] = compareResults(goodResults, faultedResults, wire, faultType);
-            faultDetected[faultType] = compareResultsToConsole(goodResults, faultedResults, wire, faultType);
+            // Run the simulation again with the fault injected and compare its outputs with the good simulation as they are produced.
+            // A fault is considered detected if the output of the circuit with the fault differs from the output of the circuit without faults,
+            // and the simulation stops at the first detection instead of producing the complete faulted results.
+            const uint64_t firstPattern = simulateUntilDetected(goodResults, nullptr);
+            printFaultDetectionToConsole(wire->getName(), faultType, firstPattern);
+            faultDetected[faultType] = firstPattern != FaultGrade::NotDetected;
             
             // Remove the injected fault from the wire, restoring it to its normal state before proceeding to the next fault type or wire.
             removeFault(wire);
@@ -301,159 +1252,101 @@ void Circuit::runFaultedSimulation() {
         for (int faultType = 0; faultType <= 1; ++faultType) {
             if (!faultDetected[faultType]) {
                 // If a fault was undetected, output a message indicating the wire and the type of fault that was missed.
-                std::cout << "Fault was undetected for " << wire->getName() << " stuck-at-" << faultType << "\n";
+                faultReport.writeUndetectedFault(wire->getName(), faultType);
             }
         }
     }
+    // Closing the report writes the lines still queued.
+    faultReport.close();
     // This process effectively tests the circuit's ability to detect stuck-at faults in all non-output wires,
     // highlighting potential vulnerabilities in the circuit's design or testing methodology.
 }
 
+// Grades the stuck-at faults of every non-output wire against the random input combinations of generateRandomInputs.
 void Circuit::runBigFaultedSimulation() {
-    auto goodResults = runBigGoodSimulation();
+    INSTRUMENT_RUN("bigFaultedSimulation");
     auto allWires = getAllWiresButOutputs();
-    size_t numWiresToTest = std::min(allWires.size(), size_t(4));
+    const size_t numWiresToTest = allWires.size();
+
+    openFaultReport();
+    if (faultEngine != FaultSimulator::SERIAL) {
+        std::vector<uint32_t> faultWires;
+        for (size_t i = 0; i < numWiresToTest; ++i) {
+            faultWires.push_back(allWires[i]->getId());
+        }
+        compileNetlist(true);
+        FaultList faultList;
+        faultList.build(compiledNetlist, faultWires, false, &netlistOptimizer);
+        std::vector<FaultGrade> grades = gradeFaultList(faultList, randomInputCombinations.size(), &randomInputCombinations);
+        INSTRUMENT_PHASE("writeReport");
+        for (size_t i = 0; i < numWiresToTest; ++i) {
+            for (int faultType = 0; faultType <= 1; ++faultType) {
+                printBigFaultDetectionToConsole(allWires[i]->getName(), faultType, grades[2 * i + faultType].firstDetection);
+            }
+        }
+        faultReport.close();
+        printDetectionSummary(grades);
+        return;
+    }
+
+    auto goodResults = runBigGoodSimulation();
 
     for (size_t i = 0; i < numWiresToTest; ++i) {
         Wire* wire = allWires[i];
         bool faultDetected[2] = {false, false};
         for (int faultType = 0; faultType <= 1; ++faultType) {
             injectFault(wire, faultType);
-            std::vector<std::vector<bool>> faultedResults = runBigGoodSimulation();
-            faultDetected[faultType] = compareBigResultsToConsole(goodResults, faultedResults, wire, faultType);
+            const uint64_t firstPattern = simulateUntilDetected(goodResults, &randomInputCombinations);
+            printBigFaultDetectionToConsole(wire->getName(), faultType, firstPattern);
+            faultDetected[faultType] = firstPattern != FaultGrade::NotDetected;
             removeFault(wire);
         }
     }
+    faultReport.close();
 }
 
-bool Circuit::compareBigResultsToConsole(const std::vector<std::vector<bool>>& goodResults, const std::vector<std::vector<bool>>& faultedResults, Wire* wire, int faultType) {
-    bool faultDetected = false;
-    for (size_t i = 0; i < goodResults.size(); ++i) {
-        if (goodResults[i] != faultedResults[i]) {
-            faultDetected = true;
-            std::cout << wire->getName() << " stuck-at-" << faultType << " with inputs: ";
-            const auto& inputsForThisTest = randomInputCombinations[i];
-            for (size_t j = 0; j < inputsForThisTest.size(); ++j) {
-                std::cout << inputsForThisTest[j] << (j < inputsForThisTest.size() - 1 ? ", " : "");
-            }
-            std::cout << " leads to different outputs.\n";
-            break;
-        }
-    }
-    if (!faultDetected) {
-        std::cout << "No fault detected on wire " << wire->getName() << " stuck-at-" << faultType << ".\n";
-    }
-    return faultDetected;
+// Reports the first random input combination that detects the fault, or that the fault stayed undetected.
+void Circuit::printBigFaultDetectionToConsole(const std::string& site, int faultType, uint64_t firstPattern) {
+    const bool detected = firstPattern != FaultGrade::NotDetected;
+    getFaultReport().writeSampledFaultDetection(site, faultType, firstPattern,
+                                                detected ? &randomInputCombinations[firstPattern] : nullptr);
 }
 
-// Compares the outputs from a fault-free simulation against outputs with a fault injected to determine if the fault is detectable.
-bool Circuit::compareResults(const std::vector<std::vector<bool>>& goodResults, const std::vector<std::vector<bool>>& faultedResults, Wire* wire, int faultType) {
-    // Count the number of input wires to the circuit, which determines the number of input combinations tested.
-    const size_t numInputs = inputs.size();
-    // Initialize a flag to track if the fault affects the circuit's behavior (output) in any way.
-    bool faultDetected = false;
-
-    // Open a file in append mode to log the results of the fault injection tests.
-    // This allows for multiple fault simulation results to be recorded in the same file without overwriting previous data.
-    std::ofstream outFile("stuck-at-results.txt", std::ios::app);
-
-    // Iterate through all the input combinations tested in the simulations.
-    for (size_t i = 0; i < goodResults.size(); ++i) {
-        // Compare the output for the current input combination between the fault-free and fault-injected simulations.
-        if (goodResults[i] != faultedResults[i]) {
-            // If there is a discrepancy, it means the fault has an observable impact on the circuit's output, thus detected.
-            faultDetected = true;
-            // Log the detection, specifying the wire with the fault, the type of fault, and the input combination that led to detection.
-            outFile << "\\" << wire->getName() 
-                    << " stuck-at-" << faultType 
-                    << " with inputs: ";
-            // Iterate through each input wire to document the binary input combination tested.
-            for (size_t j = 0; j < numInputs; ++j) {
-                // Calculate the value of each input wire for the current combination by bitwise operations.
-                bool inputValue = (i >> j) & 1;
-                // Write the input value to the file, separated by commas.
-                outFile << inputValue << (j < numInputs - 1 ? ", " : "");
-            }
-            outFile << "\n";
-            // After logging the first detection, exit the loop. This is because identifying one instance of fault detection is often sufficient to prove the fault's impact.
-            // However, this behavior can be changed to log all detections.
-            break;
-        }
-    }
-    // If after examining all input combinations, no fault impact is detected, log that the fault was undetectable for this wire.
-    if (!faultDetected) {
-        outFile << "No fault detected on wire \\" << wire->getName() << " stuck-at-" << faultType << "\n";
-    }
-    // Ensure the file is properly closed after writing to prevent data loss and release system resources.
-    outFile.close();
-    // Return the flag indicating whether the fault was detected. This information can be used for further analysis or reporting.
-    return faultDetected;
+// Reports the input combination that first detected the fault, or that the fault was undetectable for this wire.
+void Circuit::printFaultDetectionToConsole(const std::string& site, int faultType, uint64_t firstPattern) {
+    // The input values of the combination are the bits of its index, one per input wire.
+    getFaultReport().writeFaultDetection(site, faultType, firstPattern, inputs.size());
 }
 
-// Compares the outputs from a fault-free simulation against outputs with a fault injected to determine if the fault is detectable.
-bool Circuit::compareResultsToConsole(const std::vector<std::vector<bool>>& goodResults, const std::vector<std::vector<bool>>& faultedResults, Wire* wire, int faultType) {
-    // Count the number of input wires to the circuit, which determines the number of input combinations tested.
-    const size_t numInputs = inputs.size();
-    // Initialize a flag to track if the fault affects the circuit's behavior (output) in any way.
-    bool faultDetected = false;
-
-    // Iterate through all the input combinations tested in the simulations.
-    for (size_t i = 0; i < goodResults.size(); ++i) {
-        // Compare the output for the current input combination between the fault-free and fault-injected simulations.
-        if (goodResults[i] != faultedResults[i]) {
-            // If there is a discrepancy, it means the fault has an observable impact on the circuit's output, thus detected.
-            faultDetected = true;
-            // Log the detection to the console, specifying the wire with the fault, the type of fault, and the input combination that led to detection.
-            std::cout << "\\" << wire->getName() 
-                      << " stuck-at-" << faultType 
-                      << " with inputs: ";
-            // Iterate through each input wire to document the binary input combination tested.
-            for (size_t j = 0; j < numInputs; ++j) {
-                // Calculate the value of each input wire for the current combination by bitwise operations.
-                bool inputValue = (i >> j) & 1;
-                // Print the input value to the console, separated by commas.
-                std::cout << inputValue << (j < numInputs - 1 ? ", " : "");
-            }
-            std::cout << "\n";
-            // After logging the first detection, exit the loop. This is because identifying one instance of fault detection
-            // is often sufficient to prove the fault's impact. However, this behavior can be changed to log all detections.
-            break;
-        }
-    }
-    // If after examining all input combinations, no fault impact is detected, log that the fault was undetectable for this wire.
-    if (!faultDetected) {
-        std::cout << "No fault detected on wire \\" << wire->getName() << " stuck-at-" << faultType << "\n";
+// Opens the report of runFaultedSimulation and runBigFaultedSimulation: the file set with setFaultReport, or the
+// console. It is held open for the whole run.
+void Circuit::openFaultReport() {
+    faultReport.open(faultReportFile, faultReportFormat);
+}
+
+// The fault report, opened on the console if no run has opened it.
+ReportWriter& Circuit::getFaultReport() {
+    if (!faultReport.isOpen()) {
+        faultReport.open(std::string(), ReportWriter::TEXT);
     }
-    // No need to close std::cout as it is managed by the runtime.
-    // Return the flag indicating whether the fault was detected. This information can be used for further analysis or reporting.
-    return faultDetected;
+    return faultReport;
 }
 
 // Searches for a wire by its name within the circuit and returns a pointer to the wire if found.
+// The name index resolves duplicates the way a search through inputs, outputs and internal wires would.
 Wire* Circuit::findWireByName(const std::string& name) {
-    // First, iterate through the list of input wires in the circuit.
-    for (auto& wire : inputs) {
-        if (wire->getName() == name) {
-            // If a match is found, return a pointer to this wire.
-            return wire;
-        }
-    }
-    // If the wire was not found among the inputs, proceed to search among the output wires.
-    for (auto& wire : outputs) {
-        if (wire->getName() == name) {
-            // If a match is found among the outputs, return a pointer to this wire.
-            return wire;
-        }
-    }
-    // If the wire was not found among the inputs or outputs, search among the internal wires.
-    for (auto& wire : internalWires) {
-        if (wire->getName() == name) {
-            // If a match is found among the internal wires, return a pointer to this wire.
-            return wire;
+    if (!wireIndexValid) {
+        // Inputs, then outputs, then internal wires: the first wire of a name is the one a search in that order finds.
+        wireIndex.clear();
+        wireIndex.reserve(inputs.size() + outputs.size() + internalWires.size());
+        for (Wire* wire : getAllWires()) {
+            wireIndex.emplace(wire->getName(), wire);
         }
+        wireIndexValid = true;
     }
+    auto it = wireIndex.find(name);
     // return nullptr to indicate that no wire with the specified name exists in the circuit.
-    return nullptr; 
+    return it == wireIndex.end() ? nullptr : it->second;
 }
 
 // Gathers all wires in the circuit into a single vector.
@@ -484,28 +1377,65 @@ std::vector<Wire*> Circuit::getAllWiresButOutputs() const {
 
 // Adds a wire to the list of input wires for the circuit.
 void Circuit::addInput(Wire* wire) {
+    wire->setId(static_cast<uint32_t>(inputs.size() + outputs.size() + internalWires.size()));
+    // An input takes over the name from an output or internal wire of the same name.
+    if (wireIndexValid) {
+        auto indexed = wireIndex.emplace(wire->getName(), wire);
+        if (!indexed.second && std::find(inputs.begin(), inputs.end(), indexed.first->second) == inputs.end()) {
+            indexed.first->second = wire;
+        }
+    }
     inputs.push_back(wire);
+    invalidateNetlist();
 }
 
 // Adds a wire to the list of output wires for the circuit.
 void Circuit::addOutput(Wire* wire) {
+    wire->setId(static_cast<uint32_t>(inputs.size() + outputs.size() + internalWires.size()));
+    // An output takes over the name from an internal wire of the same name.
+    if (wireIndexValid) {
+        auto indexed = wireIndex.emplace(wire->getName(), wire);
+        if (!indexed.second &&
+            std::find(internalWires.begin(), internalWires.end(), indexed.first->second) != internalWires.end()) {
+            indexed.first->second = wire;
+        }
+    }
     outputs.push_back(wire);
+    invalidateNetlist();
 }
 
 // Adds a wire to the list of internal wires for the circuit.
 void Circuit::addInternalWire(Wire* wire) {
+    wire->setId(static_cast<uint32_t>(inputs.size() + outputs.size() + internalWires.size()));
+    if (wireIndexValid) {
+        wireIndex.emplace(wire->getName(), wire);
+    }
     internalWires.push_back(wire);
+    invalidateNetlist();
 }
 
 // Adds a wire to the list of gates for the circuit.
+// The driver/fanout index of the gate's wires is updated right away, so it never has to be rebuilt.
 void Circuit::addGate(Gate* gate) {
     gates.push_back(gate);
+    gate->getOutput()->setDriver(gate);
+    if (gate->getInput1()) {
+        gate->getInput1()->addFanout(gate);
+    }
+    if (gate->getInput2()) {
+        gate->getInput2()->addFanout(gate);
+    }
+    invalidateNetlist();
 }
 
 // Adds a fault to a gate.
 void Circuit::injectFault(Wire* wire, bool faultType) {
     if (wire) {
         wire->setFault(true, faultType);
+        StuckAtFault fault;
+        if (compiledNetlistValid && netlistOptimizer.resolveFault(StuckAtFault{ wire->getId(), faultType }, fault)) {
+            compiledNetlist.forceWire(fault.wire, fault.value);
+        }
     }
 }
 
@@ -513,5 +1443,9 @@ void Circuit::injectFault(Wire* wire, bool faultType) {
 void Circuit::removeFault(Wire* wire) {
     if (wire) {
         wire->clearFault();
+        StuckAtFault fault;
+        if (compiledNetlistValid && netlistOptimizer.resolveFault(StuckAtFault{ wire->getId(), false }, fault)) {
+            compiledNetlist.releaseWire(fault.wire);
+        }
     }
 }
\ No newline at end of file
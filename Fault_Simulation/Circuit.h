@@ -1,10 +1,18 @@
 ﻿#pragma once
-#include <map>
-#include <stack>
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include "Wire.h"
 #include "Gate.h"
+#include "PatternKernels.h"
+#include "CompiledNetlist.h"
+#include "FaultSimulator.h"
+#include "FaultCampaign.h"
+#include "FaultList.h"
+#include "NetlistOptimizer.h"
+#include "ResultStore.h"
+#include "RandomPatternGenerator.h"
+#include "ReportWriter.h"
 
 class Circuit {
 public:
@@ -12,37 +20,123 @@ public:
     ~Circuit();
 
     void loadFromFile(const std::string& filepath);
+    void setNetlistCache(bool enabled);
     void runAndPrintGoodSimulation();
     void runFaultedSimulation();
-    void printGoodSimulationResultsToConsole(const std::vector<std::vector<bool>>& results);
-    bool compareResultsToConsole(const std::vector<std::vector<bool>>& goodResults, const std::vector<std::vector<bool>>& faultedResults, Wire* wire, int faultType);
+    void printGoodSimulationResultsToConsole(const ResultStore& results);
 
     
     std::vector<std::vector<bool>> randomInputCombinations;
-    std::vector<std::vector<bool>> runBigGoodSimulation();
+    ResultStore runBigGoodSimulation();
     void runBigFaultedSimulation();
-    void generateRandomInputs();
-    void printBigGoodSimulationResultsToConsole(const std::vector<std::vector<bool>>& results);
-    bool compareBigResultsToConsole(const std::vector<std::vector<bool>>& goodResults, 
-                             const std::vector<std::vector<bool>>& faultedResults,
-                             Wire* wire, int faultType);
+    void generateRandomInputs(size_t count = 3);
+    void runRandomFaultCampaign();
+    void runTransitionFaultCampaign();
+    void runCubeFaultSimulation(const std::vector<std::vector<int8_t>>& cubes);
+    void printBigGoodSimulationResultsToConsole(const ResultStore& results);
 
     
-    std::vector<std::vector<bool>> runGoodSimulation();
-    void printGoodSimulationResults(const std::vector<std::vector<bool>>& results);
-    bool compareResults(const std::vector<std::vector<bool>>& goodResults, 
-                             const std::vector<std::vector<bool>>& faultedResults,
-                             Wire* wire, int faultType);
+    // Largest input count whose exhaustive responses runGoodSimulation still stores completely.
+    static const size_t MaxStoredInputs = 32;
+
+    ResultStore runGoodSimulation();
+    void runExhaustiveSweep(uint64_t firstChunk = 0, uint64_t endChunk = ~0ULL);
+    void setPatternParallel(bool enabled);
+    void setPatternKernels(PatternKernels::IsaLevel isa);
+    void setFaultEngine(FaultSimulator::Engine engine);
+    void setDetectionLimit(uint64_t limit);
+    void setFaultCollapsing(FaultList::Collapsing mode);
+    void setBranchFaults(bool enabled);
+    void setNetlistOptimization(NetlistOptimizer::Mode mode);
+    void setThreadCount(size_t threads);
+    void setResultFile(const std::string& path);
+    void setFaultReport(const std::string& path, ReportWriter::Format format);
+    void setRunReport(const std::string& path);
+    void setRandomPatterns(RandomPatternGenerator::Mode mode, uint64_t seed);
+    void setPatternBudget(uint64_t patterns);
+    void setCoveragePatience(uint64_t patterns);
+    void setAtpg(bool enabled);
+    void setBacktrackLimit(size_t limit);
+    void setCompaction(bool enabled);
+    void setCubeMerging(bool enabled);
+    void setThreeValued(bool enabled);
+    void setCriticalPathTracing(bool enabled);
+    void printGoodSimulationResults(const ResultStore& results);
 
     std::vector<Wire*> inputs;
     std::vector<Wire*> outputs;
     std::vector<Wire*> internalWires;
     std::vector<Gate*> gates;
-    std::map<Gate*, std::vector<Gate*>> adjList;
+    // Name index over all wires for findWireByName; rebuilt on the next lookup when not valid.
+    std::unordered_map<std::string, Wire*> wireIndex;
+    bool wireIndexValid = true;
+    bool netlistCacheEnabled = true;
+    std::vector<Gate*> levelizedGates;
+    bool levelizationValid = false;
+    bool patternParallel = false;
+    const PatternKernels* kernels;
+    CompiledNetlist compiledNetlist;
+    bool compiledNetlistValid = false;
+    // The optimization the compiled netlist was built with (see compileNetlist).
+    NetlistOptimizer::Mode compiledOptimization = NetlistOptimizer::NO_OPTIMIZATION;
+    std::vector<uint64_t> patternValues;
+    FaultSimulator::Engine faultEngine = FaultSimulator::SERIAL;
+    uint64_t detectionLimit = 1;
+    FaultList::Collapsing faultCollapsing = FaultList::NO_COLLAPSING;
+    bool branchFaults = false;
+    NetlistOptimizer::Mode netlistOptimization = NetlistOptimizer::NO_OPTIMIZATION;
+    NetlistOptimizer netlistOptimizer;
+    size_t faultThreads = 1;
+    // File that backs the good simulation results of runGoodSimulation; empty keeps them on the heap.
+    std::string resultFile;
+    RandomPatternGenerator::Mode randomPatternMode = RandomPatternGenerator::PRNG;
+    uint64_t randomSeed = 1;
+    uint64_t patternBudget = uint64_t(1) << 20;
+    uint64_t coveragePatience = uint64_t(1) << 16;
+    bool atpgEnabled = false;
+    size_t backtrackLimit = 100;
+    bool compactionEnabled = false;
+    bool cubeMerging = false;
+    bool threeValued = false;
+    bool criticalPathTracing = false;
+    // Report of the fault simulations (console if the file is empty).
+    std::string faultReportFile;
+    ReportWriter::Format faultReportFormat = ReportWriter::TEXT;
+    ReportWriter faultReport;
 
-    void buildGraph();
-    void topologicalSortUtil(Gate* gate, std::map<Gate*, bool>& visited, std::stack<Gate*>& stack);
-    std::stack<Gate*> topologicalSort();
+    const std::vector<Gate*>& getLevelizedGates();
+    void invalidateNetlist();
+    void compileNetlist(bool faultGrading = false);
+    void collectPatternBlockOutputs(size_t base, size_t numPatterns, ResultStore& results);
+    void loadPatternBlock(uint64_t* values, size_t words, size_t base, size_t numPatterns,
+                          const std::vector<std::vector<bool>>* patterns);
+    void loadCubeBlock(uint64_t* values, size_t words, size_t base, size_t numPatterns,
+                       const std::vector<std::vector<int8_t>>& cubes);
+    std::vector<FaultGrade> gradeStuckAtFaults(const std::vector<StuckAtFault>& faults, size_t numPatterns,
+                                               const std::vector<std::vector<bool>>* patterns);
+    std::vector<FaultGrade> gradeFaultList(FaultList& faultList, size_t numPatterns,
+                                           const std::vector<std::vector<bool>>* patterns);
+    std::vector<std::vector<bool>> generateAtpgPatterns(const std::vector<StuckAtFault>& faults,
+                                                        std::vector<FaultGrade>& grades,
+                                                        RandomPatternGenerator& generator, uint64_t firstPattern,
+                                                        std::vector<uint8_t>& redundant, size_t& aborted);
+    std::vector<std::vector<bool>> compactTestSet(const std::vector<StuckAtFault>& faults,
+                                                  const std::vector<FaultGrade>& grades,
+                                                  RandomPatternGenerator& generator, uint64_t randomPatterns,
+                                                  const std::vector<std::vector<bool>>& atpgPatterns);
+    void writeTestPatterns(const std::vector<std::vector<bool>>& patterns);
+    std::vector<std::vector<bool>> compactPatterns(const std::vector<StuckAtFault>& faults,
+                                                   std::vector<std::vector<bool>> patterns);
+    uint64_t computeResponseSignature(RandomPatternGenerator& generator, uint64_t numPatterns);
+    std::string getFaultSiteName(const StuckAtFault& fault, const std::vector<Wire*>& wiresById);
+    uint64_t simulateUntilDetected(const ResultStore& goodResults,
+                                   const std::vector<std::vector<bool>>* patterns);
+    void printDetectionSummary(const std::vector<FaultGrade>& grades);
+    void printFaultDetectionToConsole(const std::string& site, int faultType, uint64_t firstPattern);
+    void printBigFaultDetectionToConsole(const std::string& site, int faultType, uint64_t firstPattern);
+    void writeGoodResponses(const ResultStore& results, ReportWriter& report);
+    void openFaultReport();
+    ReportWriter& getFaultReport();
 
     Wire* findWireByName(const std::string& name);
     std::vector<Wire*> getAllWires() const;
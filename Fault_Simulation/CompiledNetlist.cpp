@@ -0,0 +1,212 @@
+#include "CompiledNetlist.h"
+#include <algorithm>
+#include "Instrumentation.h"
+
+const uint32_t CompiledNetlist::NoGate;
+
+CompiledNetlist::CompiledNetlist()
+    : numLevels(0), zeroWire(0), sinkWire(0), numWires(0)
+{
+
+}
+
+// Flattens the circuit into the gate arrays. 'evaluationOrder' must list every gate after the gates driving its inputs.
+void CompiledNetlist::build(const std::vector<Wire*>& allWires, const std::vector<Wire*>& inputs,
+                            const std::vector<Wire*>& outputs, const std::vector<Gate*>& evaluationOrder) {
+    // The circuit's wires keep their ids, the two reserved wires are appended behind them.
+    zeroWire = static_cast<uint32_t>(allWires.size());
+    sinkWire = zeroWire + 1;
+    numWires = allWires.size() + 2;
+
+    const size_t numGates = evaluationOrder.size();
+    gateType.assign(numGates, 0);
+    negInput1.assign(numGates, 0);
+    negInput2.assign(numGates, 0);
+    gateInput1.assign(numGates, zeroWire);
+    gateInput2.assign(numGates, zeroWire);
+    gateOutput.assign(numGates, sinkWire);
+    gateLevel.assign(numGates, 0);
+    driverGate.assign(numWires, NoGate);
+    numLevels = 0;
+
+    for (size_t i = 0; i < numGates; ++i) {
+        const Gate* gate = evaluationOrder[i];
+        gateType[i] = static_cast<uint8_t>(gate->getType());
+        // Missing inputs read the constant-0 wire without negation, and NOT/BUFFER never read their second input,
+        // which reproduces Gate::computeOutput exactly.
+        if (gate->getInput1()) {
+            gateInput1[i] = gate->getInput1()->getId();
+            negInput1[i] = gate->getNegInput1();
+        }
+        if (gate->getInput2() && gate->getType() != Gate::NOT && gate->getType() != Gate::BUFFER) {
+            gateInput2[i] = gate->getInput2()->getId();
+            negInput2[i] = gate->getNegInput2();
+        }
+        gateOutput[i] = gate->getOutput()->getId();
+        driverGate[gateOutput[i]] = static_cast<uint32_t>(i);
+        gateLevel[i] = static_cast<uint32_t>(gate->getLevel());
+        numLevels = std::max(numLevels, gateLevel[i] + 1);
+    }
+
+    // Count the gate pins reading each wire, then fill the fanout lists in gate order.
+    // The reserved constant-0 wire is not a real fanout source and is left out.
+    fanoutStart.assign(numWires + 1, 0);
+    for (size_t i = 0; i < numGates; ++i) {
+        if (gateInput1[i] != zeroWire) {
+            ++fanoutStart[gateInput1[i] + 1];
+        }
+        if (gateInput2[i] != zeroWire) {
+            ++fanoutStart[gateInput2[i] + 1];
+        }
+    }
+    for (size_t w = 0; w < numWires; ++w) {
+        fanoutStart[w + 1] += fanoutStart[w];
+    }
+    fanoutGates.assign(fanoutStart[numWires], 0);
+    std::vector<uint32_t> fill(fanoutStart.begin(), fanoutStart.end() - 1);
+    for (size_t i = 0; i < numGates; ++i) {
+        if (gateInput1[i] != zeroWire) {
+            fanoutGates[fill[gateInput1[i]]++] = static_cast<uint32_t>(i);
+        }
+        if (gateInput2[i] != zeroWire) {
+            fanoutGates[fill[gateInput2[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    inputIds.clear();
+    for (Wire* wire : inputs) {
+        inputIds.push_back(wire->getId());
+    }
+    outputIds.clear();
+    isOutput.assign(numWires, 0);
+    for (Wire* wire : outputs) {
+        outputIds.push_back(wire->getId());
+        isOutput[wire->getId()] = 1;
+    }
+
+    forcedWires.clear();
+    forcedValue.assign(numWires, 0);
+    isForced.assign(numWires, 0);
+    buildGateRuns();
+}
+
+// Splits the gate arrays into maximal runs of one opcode. A run may continue into the next level, since its
+// gates are still evaluated one after the other.
+void CompiledNetlist::buildGateRuns() {
+    gateRunStart.clear();
+    gateRunOpcode.clear();
+    const size_t numGates = gateType.size();
+    for (size_t i = 0; i < numGates; ++i) {
+        const uint8_t opcode = static_cast<uint8_t>(4 * gateType[i] + 2 * negInput1[i] + negInput2[i]);
+        if (gateRunOpcode.empty() || gateRunOpcode.back() != opcode) {
+            gateRunStart.push_back(static_cast<uint32_t>(i));
+            gateRunOpcode.push_back(opcode);
+        }
+    }
+    gateRunStart.push_back(static_cast<uint32_t>(numGates));
+}
+
+// Completes a netlist whose public arrays were filled directly (see NetlistCache): places the reserved wires
+// behind the circuit's own and clears the injected faults.
+void CompiledNetlist::setCircuitWireCount(size_t circuitWires) {
+    zeroWire = static_cast<uint32_t>(circuitWires);
+    sinkWire = zeroWire + 1;
+    numWires = circuitWires + 2;
+    forcedWires.clear();
+    forcedValue.assign(numWires, 0);
+    isForced.assign(numWires, 0);
+    buildGateRuns();
+}
+
+// Injects a stuck-at fault: the driving gate writes into the sink instead, and the wire keeps its forced value.
+void CompiledNetlist::forceWire(uint32_t wire, bool value) {
+    if (!isForced[wire]) {
+        forcedWires.push_back(wire);
+        isForced[wire] = 1;
+    }
+    forcedValue[wire] = value;
+    if (driverGate[wire] != NoGate) {
+        gateOutput[driverGate[wire]] = sinkWire;
+    }
+}
+
+// Removes a stuck-at fault injected with forceWire.
+void CompiledNetlist::releaseWire(uint32_t wire) {
+    if (!isForced[wire]) {
+        return;
+    }
+    isForced[wire] = 0;
+    forcedWires.erase(std::find(forcedWires.begin(), forcedWires.end(), wire));
+    if (driverGate[wire] != NoGate) {
+        gateOutput[driverGate[wire]] = wire;
+    }
+}
+
+// Removes every injected stuck-at fault.
+void CompiledNetlist::releaseAllWires() {
+    while (!forcedWires.empty()) {
+        releaseWire(forcedWires.back());
+    }
+}
+
+// Sets one 64-lane word of a primary input. Stuck inputs ignore the stimulus and keep their forced value.
+void CompiledNetlist::setInputWord(uint64_t* values, size_t words, size_t inputIndex, size_t wordIndex, uint64_t word) const {
+    const uint32_t wire = inputIds[inputIndex];
+    if (!isForced[wire]) {
+        values[wire * words + wordIndex] = word;
+    }
+}
+
+// Evaluates all gates in order for one pattern block of 'words' 64-bit words per wire, one run kernel call per
+// gate run. The input words must have been set; 'words' has to match the block width of 'kernels'.
+void CompiledNetlist::simulate(uint64_t* values, size_t words, const PatternKernels& kernels) const {
+    std::fill(values + zeroWire * words, values + (zeroWire + 1) * words, uint64_t(0));
+    for (uint32_t wire : forcedWires) {
+        std::fill(values + wire * words, values + (wire + 1) * words, forcedValue[wire] ? ~uint64_t(0) : uint64_t(0));
+    }
+
+    INSTRUMENT_COUNT(GATE_EVALUATIONS, gateType.size());
+    for (size_t r = 0; r < gateRunOpcode.size(); ++r) {
+        const uint32_t first = gateRunStart[r];
+        kernels.evaluateGateRun[gateRunOpcode[r]](&gateInput1[first], &gateInput2[first], &gateOutput[first],
+                                                  gateRunStart[r + 1] - first, values);
+    }
+}
+
+// Sets every wire of a dual-rail value array to a definite 0, the value undriven wires read as in the two-valued
+// simulation. Primary inputs stay 0 until setInputRails assigns them.
+void CompiledNetlist::clearDualRail(uint64_t* values, size_t words) const {
+    for (size_t wire = 0; wire < numWires; ++wire) {
+        std::fill(values + 2 * wire * words, values + (2 * wire + 1) * words, uint64_t(0));
+        std::fill(values + (2 * wire + 1) * words, values + (2 * wire + 2) * words, ~uint64_t(0));
+    }
+}
+
+// Sets word 'wordIndex' of a primary input in a dual-rail array: 'ones' are the lanes holding 1, 'zeros' those
+// holding 0, and lanes in neither are X. Both must not share a lane.
+void CompiledNetlist::setInputRails(uint64_t* values, size_t words, size_t inputIndex, size_t wordIndex,
+                                    uint64_t ones, uint64_t zeros) const {
+    const uint32_t wire = inputIds[inputIndex];
+    if (!isForced[wire]) {
+        values[2 * wire * words + wordIndex] = ones;
+        values[(2 * wire + 1) * words + wordIndex] = zeros;
+    }
+}
+
+// Evaluates all gates in order for one pattern block in three-valued dual-rail form, with the same run kernel calls
+// as simulate. The array must have been cleared once with clearDualRail and the input rails set.
+void CompiledNetlist::simulateDualRail(uint64_t* values, size_t words, const PatternKernels& kernels) const {
+    std::fill(values + 2 * zeroWire * words, values + (2 * zeroWire + 1) * words, uint64_t(0));
+    std::fill(values + (2 * zeroWire + 1) * words, values + (2 * zeroWire + 2) * words, ~uint64_t(0));
+    for (uint32_t wire : forcedWires) {
+        std::fill(values + 2 * wire * words, values + (2 * wire + 1) * words, forcedValue[wire] ? ~uint64_t(0) : uint64_t(0));
+        std::fill(values + (2 * wire + 1) * words, values + (2 * wire + 2) * words, forcedValue[wire] ? uint64_t(0) : ~uint64_t(0));
+    }
+
+    INSTRUMENT_COUNT(GATE_EVALUATIONS, gateType.size());
+    for (size_t r = 0; r < gateRunOpcode.size(); ++r) {
+        const uint32_t first = gateRunStart[r];
+        kernels.evaluateGateRunDualRail[gateRunOpcode[r]](&gateInput1[first], &gateInput2[first], &gateOutput[first],
+                                                          gateRunStart[r + 1] - first, values);
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Wire.h"
+#include "Gate.h"
+#include "PatternKernels.h"
+
+// Flat, levelized struct-of-arrays form of a circuit, built once after parsing.
+// Gates are stored in evaluation order as parallel arrays of opcode, negation flags and wire ids,
+// and the simulation state is a dense array of pattern blocks indexed by wire id (value block of wire w
+// starts at values[w * words]), so simulating a block needs neither allocation nor pointer chasing.
+// The three-valued simulation uses a dual-rail array with two blocks per wire: the lanes in which the wire is
+// definitely 1 at values[2 * w * words] and those in which it is definitely 0 right behind; X is neither.
+class CompiledNetlist {
+public:
+    static const uint32_t NoGate = 0xFFFFFFFFu;
+
+    CompiledNetlist();
+
+    void build(const std::vector<Wire*>& allWires, const std::vector<Wire*>& inputs,
+               const std::vector<Wire*>& outputs, const std::vector<Gate*>& evaluationOrder);
+
+    void setCircuitWireCount(size_t circuitWires);
+
+    size_t getNumWires() const { return numWires; }
+    size_t getNumGates() const { return gateType.size(); }
+    size_t getValueArraySize(size_t words) const { return numWires * words; }
+    size_t getDualRailArraySize(size_t words) const { return 2 * numWires * words; }
+
+    void forceWire(uint32_t wire, bool value);
+    void releaseWire(uint32_t wire);
+    void releaseAllWires();
+
+    void setInputWord(uint64_t* values, size_t words, size_t inputIndex, size_t wordIndex, uint64_t word) const;
+    void simulate(uint64_t* values, size_t words, const PatternKernels& kernels) const;
+
+    void clearDualRail(uint64_t* values, size_t words) const;
+    void setInputRails(uint64_t* values, size_t words, size_t inputIndex, size_t wordIndex,
+                       uint64_t ones, uint64_t zeros) const;
+    void simulateDualRail(uint64_t* values, size_t words, const PatternKernels& kernels) const;
+
+    // Gate arrays, one entry per gate in evaluation order.
+    std::vector<uint8_t> gateType;
+    std::vector<uint8_t> negInput1;
+    std::vector<uint8_t> negInput2;
+    std::vector<uint32_t> gateInput1;
+    std::vector<uint32_t> gateInput2;
+    std::vector<uint32_t> gateOutput;
+
+    // Wire ids of the primary inputs and outputs, in the circuit's declaration order.
+    std::vector<uint32_t> inputIds;
+    std::vector<uint32_t> outputIds;
+    // Position of the gate driving each wire, or NoGate for primary inputs and undriven wires.
+    std::vector<uint32_t> driverGate;
+    // Logic level of each gate; levels never decrease along the gate arrays.
+    std::vector<uint32_t> gateLevel;
+    uint32_t numLevels;
+    // Fanout of each wire in compressed form: the gates reading wire w are
+    // fanoutGates[fanoutStart[w]] .. fanoutGates[fanoutStart[w + 1] - 1].
+    std::vector<uint32_t> fanoutStart;
+    std::vector<uint32_t> fanoutGates;
+    // 1 for wires that are primary outputs.
+    std::vector<uint8_t> isOutput;
+    // Runs of consecutive gates sharing an opcode (see Gate::getOpcode); run r covers gates
+    // gateRunStart[r] .. gateRunStart[r + 1] - 1. The levelization groups each level by opcode, so a level
+    // needs at most sixteen runs.
+    std::vector<uint32_t> gateRunStart;
+    std::vector<uint8_t> gateRunOpcode;
+
+    // Two reserved wires after the circuit's own: a constant-0 source for missing gate inputs
+    // and a sink that absorbs the output of a gate whose output wire is stuck.
+    uint32_t zeroWire;
+    uint32_t sinkWire;
+
+private:
+    void buildGateRuns();
+
+    size_t numWires;
+    std::vector<uint32_t> forcedWires;
+    std::vector<uint8_t> forcedValue;
+    std::vector<uint8_t> isForced;
+};
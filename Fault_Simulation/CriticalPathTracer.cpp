@@ -0,0 +1,90 @@
+#include "CriticalPathTracer.h"
+#include <algorithm>
+
+CriticalPathTracer::CriticalPathTracer(const CompiledNetlist& netlist)
+    : netlist(netlist)
+{
+    // The fanout lists hold one entry per reading gate pin, so a gate reading a wire twice makes it a stem.
+    const size_t numWires = netlist.getNumWires();
+    stemOf.resize(numWires);
+    for (uint32_t wire = 0; wire < numWires; ++wire) {
+        stemOf[wire] = wire;
+    }
+    // Walking the gates backwards resolves a gate's output before its inputs.
+    for (uint32_t g = static_cast<uint32_t>(netlist.getNumGates()); g-- > 0;) {
+        const uint32_t output = netlist.gateOutput[g];
+        const uint32_t pins[2] = { netlist.gateInput1[g], netlist.gateInput2[g] };
+        for (uint32_t wire : pins) {
+            const uint32_t readers = netlist.fanoutStart[wire + 1] - netlist.fanoutStart[wire];
+            if (wire != netlist.zeroWire && readers == 1 && !netlist.isOutput[wire]) {
+                stemOf[wire] = stemOf[output];
+            }
+        }
+    }
+    for (uint32_t wire = 0; wire < numWires; ++wire) {
+        if (stemOf[wire] == wire) {
+            stems.push_back(wire);
+        }
+    }
+}
+
+// Stem of the region holding the fault site; a branch fault sits in the region of its gate.
+uint32_t CriticalPathTracer::getFaultStem(const StuckAtFault& fault) const {
+    return stemOf[fault.isBranch() ? netlist.gateOutput[fault.gate] : fault.wire];
+}
+
+// Computes for every wire the lanes in which it is critical for the stem of its region, i.e. in which flipping
+// the wire alone flips the stem, by tracing backwards from each stem through the pins that are sensitive under
+// the good values. Stems are critical in every lane. 'criticality' has the layout of the value array.
+void CriticalPathTracer::traceBlock(const uint64_t* goodValues, size_t words, uint64_t* criticality) const {
+    for (uint32_t stem : stems) {
+        std::fill(criticality + stem * words, criticality + (stem + 1) * words, ~uint64_t(0));
+    }
+    for (uint32_t g = static_cast<uint32_t>(netlist.getNumGates()); g-- > 0;) {
+        const uint32_t output = netlist.gateOutput[g];
+        for (uint8_t pin = 0; pin < 2; ++pin) {
+            const uint32_t wire = pin == 0 ? netlist.gateInput1[g] : netlist.gateInput2[g];
+            if (isStem(wire)) {
+                continue;
+            }
+            for (size_t w = 0; w < words; ++w) {
+                criticality[wire * words + w] = criticality[output * words + w]
+                                                & getPinSensitivity(g, pin, goodValues, words, w);
+            }
+        }
+    }
+}
+
+// Sets 'sensitizedLanes' (one word per block word) to the lanes in which a fault inside a region is activated
+// at its site and its effect reaches the stem: the site is critical, or for a branch fault its gate pin is
+// sensitive and the gate output critical. The fault is detected in those of the lanes in which the stem's flip
+// is observed at a primary output.
+void CriticalPathTracer::getSensitizedLanes(const StuckAtFault& fault, const uint64_t* goodValues,
+                                            const uint64_t* criticality, size_t words,
+                                            uint64_t* sensitizedLanes) const {
+    const uint64_t stuckWord = fault.value ? ~uint64_t(0) : uint64_t(0);
+    for (size_t w = 0; w < words; ++w) {
+        const uint64_t activated = goodValues[fault.wire * words + w] ^ stuckWord;
+        if (fault.isBranch()) {
+            const uint32_t output = netlist.gateOutput[fault.gate];
+            sensitizedLanes[w] = activated & criticality[output * words + w]
+                                 & getPinSensitivity(fault.gate, fault.pin, goodValues, words, w);
+        } else {
+            sensitizedLanes[w] = activated & criticality[fault.wire * words + w];
+        }
+    }
+}
+
+// Lanes of block word 'wordIndex' in which a change on the gate pin changes the gate output: always for NOT and
+// BUFFER, where the other pin is 1 for AND and where it is 0 for OR (after its negation).
+uint64_t CriticalPathTracer::getPinSensitivity(uint32_t gate, uint8_t pin, const uint64_t* goodValues, size_t words,
+                                               size_t wordIndex) const {
+    const uint8_t type = netlist.gateType[gate];
+    if (type != Gate::AND && type != Gate::OR) {
+        return pin == 0 ? ~uint64_t(0) : uint64_t(0);
+    }
+    const uint32_t other = pin == 0 ? netlist.gateInput2[gate] : netlist.gateInput1[gate];
+    const bool negated = (pin == 0 ? netlist.negInput2[gate] : netlist.negInput1[gate]) != 0;
+    const uint64_t otherValue = goodValues[other * words + wordIndex] ^ (negated ? ~uint64_t(0) : uint64_t(0));
+    return type == Gate::AND ? otherValue : ~otherValue;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CompiledNetlist.h"
+#include "FaultSimulator.h"
+
+// Partitions a compiled netlist into fanout-free regions (FFRs) and resolves the faults inside them by critical
+// path tracing instead of simulating them. A stem is a wire that is a primary output or is not read by exactly
+// one gate pin; every other wire feeds a single gate, and the chain of those gates ends in the stem whose region
+// the wire belongs to. A fault effect inside a region can only leave it through the stem, so a fault there is
+// detected exactly in the lanes where it is activated, its site is critical (flipping it flips the stem) and a
+// flip of the stem is observed at a primary output. Only the stem faults need an explicit fault simulation.
+class CriticalPathTracer {
+public:
+    explicit CriticalPathTracer(const CompiledNetlist& netlist);
+
+    bool isStem(uint32_t wire) const { return stemOf[wire] == wire; }
+    uint32_t getStem(uint32_t wire) const { return stemOf[wire]; }
+    uint32_t getFaultStem(const StuckAtFault& fault) const;
+    size_t getNumStems() const { return stems.size(); }
+
+    void traceBlock(const uint64_t* goodValues, size_t words, uint64_t* criticality) const;
+    void getSensitizedLanes(const StuckAtFault& fault, const uint64_t* goodValues, const uint64_t* criticality,
+                            size_t words, uint64_t* sensitizedLanes) const;
+
+private:
+    uint64_t getPinSensitivity(uint32_t gate, uint8_t pin, const uint64_t* goodValues, size_t words,
+                               size_t wordIndex) const;
+
+    const CompiledNetlist& netlist;
+    // Stem of the region each wire belongs to; a stem is its own.
+    std::vector<uint32_t> stemOf;
+    // Every stem, whether driven by a gate, a primary input or undriven.
+    std::vector<uint32_t> stems;
+};
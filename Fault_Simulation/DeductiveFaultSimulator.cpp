@@ -0,0 +1,215 @@
+#include "DeductiveFaultSimulator.h"
+#include <algorithm>
+#include "Instrumentation.h"
+
+DeductiveFaultSimulator::DeductiveFaultSimulator(const CompiledNetlist& netlist)
+    : netlist(netlist),
+      wireFaultStart(netlist.getNumWires() + 1, 0),
+      pinFaultStart(2 * netlist.getNumGates() + 1, 0),
+      sets(netlist.getNumWires())
+{
+
+}
+
+// Loads the faults to grade, fault i under index i, replacing the previous ones. Stem faults are attached to
+// their wire and branch faults to their gate pin.
+void DeductiveFaultSimulator::loadFaults(const StuckAtFault* faults, size_t count) {
+    std::fill(wireFaultStart.begin(), wireFaultStart.end(), 0u);
+    std::fill(pinFaultStart.begin(), pinFaultStart.end(), 0u);
+    for (size_t i = 0; i < count; ++i) {
+        if (faults[i].isBranch()) {
+            ++pinFaultStart[2 * faults[i].gate + faults[i].pin + 1];
+        } else {
+            ++wireFaultStart[faults[i].wire + 1];
+        }
+    }
+    for (size_t i = 1; i < wireFaultStart.size(); ++i) {
+        wireFaultStart[i] += wireFaultStart[i - 1];
+    }
+    for (size_t i = 1; i < pinFaultStart.size(); ++i) {
+        pinFaultStart[i] += pinFaultStart[i - 1];
+    }
+    wireFaultIds.resize(wireFaultStart.back());
+    wireFaultValues.resize(wireFaultStart.back());
+    pinFaultIds.resize(pinFaultStart.back());
+    pinFaultValues.resize(pinFaultStart.back());
+
+    // Filling the ranges in fault order keeps the ids of every range ascending.
+    std::vector<uint32_t> wireFill(wireFaultStart.begin(), wireFaultStart.end() - 1);
+    std::vector<uint32_t> pinFill(pinFaultStart.begin(), pinFaultStart.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+        if (faults[i].isBranch()) {
+            const uint32_t slot = pinFill[2 * faults[i].gate + faults[i].pin]++;
+            pinFaultIds[slot] = static_cast<uint32_t>(i);
+            pinFaultValues[slot] = faults[i].value;
+        } else {
+            const uint32_t slot = wireFill[faults[i].wire]++;
+            wireFaultIds[slot] = static_cast<uint32_t>(i);
+            wireFaultValues[slot] = faults[i].value;
+        }
+    }
+    detectedWords.assign((count + 63) / 64, 0);
+}
+
+// Grades the loaded faults against pattern 'lane' of a simulated single-word block (one word per wire) and sets
+// 'detected' to the ascending indices of the faults that flip a primary output.
+void DeductiveFaultSimulator::simulatePattern(const uint64_t* goodValues, size_t lane, std::vector<uint32_t>& detected) {
+    // Every wire starts with its own activated stem faults; primary inputs and undriven wires keep just those.
+    const uint32_t numWires = static_cast<uint32_t>(netlist.getNumWires());
+    for (uint32_t wire = 0; wire < numWires; ++wire) {
+        collectActivated(wireFaultStart, wireFaultIds, wireFaultValues, wire, (goodValues[wire] >> lane) & 1,
+                         sets[wire]);
+    }
+
+    const size_t numGates = netlist.getNumGates();
+    INSTRUMENT_COUNT(GATE_EVALUATIONS, numGates);
+    for (uint32_t i = 0; i < numGates; ++i) {
+        const FaultSet& set1 = getPinSet(i, 0, goodValues, lane, pinScratch[0]);
+        switch (netlist.gateType[i]) {
+            case Gate::AND:
+            case Gate::OR: {
+                const FaultSet& set2 = getPinSet(i, 1, goodValues, lane, pinScratch[1]);
+                const uint64_t controlling = netlist.gateType[i] == Gate::AND ? 0 : 1;
+                const uint64_t value1 = ((goodValues[netlist.gateInput1[i]] >> lane) & 1) ^ netlist.negInput1[i];
+                const uint64_t value2 = ((goodValues[netlist.gateInput2[i]] >> lane) & 1) ^ netlist.negInput2[i];
+                const bool controlling1 = value1 == controlling;
+                const bool controlling2 = value2 == controlling;
+                if (controlling1 && controlling2) {
+                    intersect(set1, set2, gateSet);
+                } else if (controlling1) {
+                    subtract(set1, set2, gateSet);
+                } else if (controlling2) {
+                    subtract(set2, set1, gateSet);
+                } else {
+                    unite(set1, set2, gateSet);
+                }
+                break;
+            }
+            case Gate::NOT:
+            case Gate::BUFFER:
+                gateSet.assign(set1.begin(), set1.end());
+                break;
+            default:
+                gateSet.clear();
+                break;
+        }
+        FaultSet& output = sets[netlist.gateOutput[i]];
+        if (output.empty()) {
+            output.swap(gateSet);
+        } else {
+            unite(gateSet, output, combined);
+            output.swap(combined);
+        }
+    }
+
+    // A fault is detected when it flips at least one primary output.
+    detectedKeys.clear();
+    for (uint32_t output : netlist.outputIds) {
+        for (const SetWord& word : sets[output]) {
+            if (!detectedWords[word.key]) {
+                detectedKeys.push_back(word.key);
+            }
+            detectedWords[word.key] |= word.bits;
+        }
+    }
+    std::sort(detectedKeys.begin(), detectedKeys.end());
+    detected.clear();
+    for (uint32_t key : detectedKeys) {
+        for (uint64_t bits = detectedWords[key]; bits; bits &= bits - 1) {
+            detected.push_back(64 * key + lowestSetLane(bits));
+        }
+        detectedWords[key] = 0;
+    }
+}
+
+// Returns the set of faults that flip what a gate pin reads: its wire's set, plus the pin's activated branch faults.
+const DeductiveFaultSimulator::FaultSet& DeductiveFaultSimulator::getPinSet(uint32_t gate, uint8_t pin,
+                                                                             const uint64_t* goodValues, size_t lane,
+                                                                             FaultSet& scratch) {
+    const uint32_t wire = pin == 0 ? netlist.gateInput1[gate] : netlist.gateInput2[gate];
+    const uint32_t slot = 2 * gate + pin;
+    if (pinFaultStart[slot] == pinFaultStart[slot + 1]) {
+        return sets[wire];
+    }
+    collectActivated(pinFaultStart, pinFaultIds, pinFaultValues, slot, (goodValues[wire] >> lane) & 1, local);
+    unite(sets[wire], local, scratch);
+    return scratch;
+}
+
+// Sets 'result' to the faults of a site's range whose stuck value differs from the good value there.
+void DeductiveFaultSimulator::collectActivated(const std::vector<uint32_t>& start, const std::vector<uint32_t>& ids,
+                                               const std::vector<uint8_t>& values, uint32_t site, bool goodValue,
+                                               FaultSet& result) const {
+    result.clear();
+    for (uint32_t i = start[site]; i < start[site + 1]; ++i) {
+        if ((values[i] != 0) != goodValue) {
+            addFault(result, ids[i]);
+        }
+    }
+}
+
+// Appends a fault to a set; it must not precede the faults already in it.
+void DeductiveFaultSimulator::addFault(FaultSet& set, uint32_t fault) {
+    const uint32_t key = fault / 64;
+    const uint64_t bit = uint64_t(1) << (fault % 64);
+    if (!set.empty() && set.back().key == key) {
+        set.back().bits |= bit;
+    } else {
+        set.push_back(SetWord{ bit, key });
+    }
+}
+
+// The set operations merge the words of both sets by position and leave out the words that become zero.
+void DeductiveFaultSimulator::unite(const FaultSet& a, const FaultSet& b, FaultSet& result) {
+    result.clear();
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i].key < b[j].key) {
+            result.push_back(a[i++]);
+        } else if (b[j].key < a[i].key) {
+            result.push_back(b[j++]);
+        } else {
+            result.push_back(SetWord{ a[i].bits | b[j].bits, a[i].key });
+            ++i;
+            ++j;
+        }
+    }
+    result.insert(result.end(), a.begin() + i, a.end());
+    result.insert(result.end(), b.begin() + j, b.end());
+}
+
+void DeductiveFaultSimulator::intersect(const FaultSet& a, const FaultSet& b, FaultSet& result) {
+    result.clear();
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i].key < b[j].key) {
+            ++i;
+        } else if (b[j].key < a[i].key) {
+            ++j;
+        } else {
+            const uint64_t bits = a[i].bits & b[j].bits;
+            if (bits) {
+                result.push_back(SetWord{ bits, a[i].key });
+            }
+            ++i;
+            ++j;
+        }
+    }
+}
+
+// Sets 'result' to the faults of 'a' that are not in 'b'.
+void DeductiveFaultSimulator::subtract(const FaultSet& a, const FaultSet& b, FaultSet& result) {
+    result.clear();
+    size_t j = 0;
+    for (const SetWord& word : a) {
+        while (j < b.size() && b[j].key < word.key) {
+            ++j;
+        }
+        const uint64_t bits = j < b.size() && b[j].key == word.key ? word.bits & ~b[j].bits : word.bits;
+        if (bits) {
+            result.push_back(SetWord{ bits, word.key });
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CompiledNetlist.h"
+#include "FaultSimulator.h"
+
+// Deductive fault simulation: for one pattern, every wire gets the set of loaded faults that would flip it.
+// The sets are derived gate by gate in level order from the good values: a gate whose pins are all at the
+// non-controlling value passes on the union of its pin sets, one with controlling pins the faults that flip every
+// controlling pin and no other pin, and NOT and BUFFER pass on their pin's set. A wire's own activated stem faults
+// (and a pin's activated branch faults) are added on top. The faults in the sets of the primary outputs are the
+// ones the pattern detects, so a single pass grades the whole fault list.
+// Fault sets are compressed bitmaps: the non-zero 64-bit words of the bitmap over the fault indices, sorted by
+// their position, so sparse sets stay small and the set operations are linear merges over contiguous memory.
+class DeductiveFaultSimulator {
+public:
+    explicit DeductiveFaultSimulator(const CompiledNetlist& netlist);
+
+    void loadFaults(const StuckAtFault* faults, size_t count);
+    void simulatePattern(const uint64_t* goodValues, size_t lane, std::vector<uint32_t>& detected);
+
+private:
+    // One non-zero word of a compressed bitmap: faults 64 * key .. 64 * key + 63.
+    struct SetWord {
+        uint64_t bits;
+        uint32_t key;
+    };
+    typedef std::vector<SetWord> FaultSet;
+
+    static void unite(const FaultSet& a, const FaultSet& b, FaultSet& result);
+    static void intersect(const FaultSet& a, const FaultSet& b, FaultSet& result);
+    static void subtract(const FaultSet& a, const FaultSet& b, FaultSet& result);
+    static void addFault(FaultSet& set, uint32_t fault);
+    void collectActivated(const std::vector<uint32_t>& start, const std::vector<uint32_t>& ids,
+                          const std::vector<uint8_t>& values, uint32_t site, bool goodValue, FaultSet& result) const;
+    const FaultSet& getPinSet(uint32_t gate, uint8_t pin, const uint64_t* goodValues, size_t lane, FaultSet& scratch);
+
+    const CompiledNetlist& netlist;
+    // Loaded stem faults per wire and branch faults per gate pin (2 * gate + pin), as index ranges into the id and
+    // stuck value lists; the ids of a range are ascending.
+    std::vector<uint32_t> wireFaultStart;
+    std::vector<uint32_t> wireFaultIds;
+    std::vector<uint8_t> wireFaultValues;
+    std::vector<uint32_t> pinFaultStart;
+    std::vector<uint32_t> pinFaultIds;
+    std::vector<uint8_t> pinFaultValues;
+
+    std::vector<FaultSet> sets;
+    FaultSet local;
+    FaultSet pinScratch[2];
+    FaultSet gateSet;
+    FaultSet combined;
+    std::vector<uint64_t> detectedWords;
+    std::vector<uint32_t> detectedKeys;
+};
@@ -0,0 +1,108 @@
+#include "ExhaustiveSweep.h"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include "WorkStealingScheduler.h"
+
+const size_t ExhaustiveSweep::MaxInputs;
+
+ExhaustiveSweep::ExhaustiveSweep(const CompiledNetlist& netlist, const PatternKernels& kernels)
+    : netlist(netlist),
+      kernels(kernels),
+      numThreads(1),
+      chunkBits(20),
+      patternsSimulated(0)
+{
+
+}
+
+// Sets how many worker threads simulate chunks; 0 uses one per hardware thread.
+void ExhaustiveSweep::setThreadCount(size_t threads) {
+    if (threads == 0) {
+        threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    numThreads = threads;
+}
+
+// Sets the chunk size to 2^bits input combinations (at least one word of 64).
+void ExhaustiveSweep::setChunkBits(unsigned bits) {
+    chunkBits = std::min<unsigned>(std::max<unsigned>(bits, 6), static_cast<unsigned>(MaxInputs));
+}
+
+uint64_t ExhaustiveSweep::getChunkPatterns() const {
+    return std::min(uint64_t(1) << chunkBits, getNumPatterns());
+}
+
+// Simulates the chunks firstChunk .. endChunk-1 (endChunk is clipped to the number of chunks) and calls
+// 'handler' on the calling thread for each of them in chunk order. Workers simulate a batch of chunks at a
+// time, so only one batch of summaries is held in memory. Returns false if the netlist has too many inputs.
+bool ExhaustiveSweep::run(uint64_t firstChunk, uint64_t endChunk, const ChunkHandler& handler) {
+    onesPerOutput.assign(netlist.outputIds.size(), 0);
+    patternsSimulated = 0;
+    if (netlist.inputIds.size() > MaxInputs) {
+        std::cerr << "Error: An exhaustive sweep supports at most " << MaxInputs << " inputs, the netlist has "
+                  << netlist.inputIds.size() << "." << std::endl;
+        return false;
+    }
+    endChunk = std::min(endChunk, getNumChunks());
+    if (firstChunk >= endChunk) {
+        return true;
+    }
+
+    WorkStealingScheduler scheduler(numThreads);
+    std::vector<std::vector<uint64_t>> workerValues(scheduler.getNumWorkers(),
+        std::vector<uint64_t>(netlist.getValueArraySize(kernels.blockWords), 0));
+    // Enough chunks per batch for work stealing to even out the workers' progress.
+    const uint64_t batchSize = 16 * scheduler.getNumWorkers();
+    std::vector<SweepChunkSummary> summaries(static_cast<size_t>(batchSize));
+
+    for (uint64_t batchBegin = firstChunk; batchBegin < endChunk; batchBegin += batchSize) {
+        const size_t batchChunks = static_cast<size_t>(std::min(batchSize, endChunk - batchBegin));
+        scheduler.run(batchChunks, [&](size_t worker, size_t chunk) {
+            summaries[chunk].chunk = batchBegin + chunk;
+            simulateChunk(workerValues[worker], summaries[chunk]);
+        });
+        for (size_t i = 0; i < batchChunks; ++i) {
+            const SweepChunkSummary& summary = summaries[i];
+            for (size_t k = 0; k < onesPerOutput.size(); ++k) {
+                onesPerOutput[k] += summary.onesPerOutput[k];
+            }
+            patternsSimulated += summary.numPatterns;
+            handler(summary);
+        }
+    }
+    return true;
+}
+
+// Simulates the input combinations of one chunk block by block and reduces the output words to its summary.
+void ExhaustiveSweep::simulateChunk(std::vector<uint64_t>& values, SweepChunkSummary& summary) const {
+    const size_t words = kernels.blockWords;
+    const uint64_t blockPatterns = 64 * words;
+    const size_t numInputs = netlist.inputIds.size();
+    const size_t numOutputs = netlist.outputIds.size();
+    summary.numPatterns = getChunkPatterns();
+    summary.firstPattern = summary.chunk * summary.numPatterns;
+    summary.onesPerOutput.assign(numOutputs, 0);
+    uint64_t signature = 14695981039346656037ULL;
+
+    for (uint64_t offset = 0; offset < summary.numPatterns; offset += blockPatterns) {
+        const uint64_t base = summary.firstPattern + offset;
+        const size_t numPatterns = static_cast<size_t>(std::min(blockPatterns, summary.numPatterns - offset));
+        for (size_t j = 0; j < numInputs; ++j) {
+            for (size_t w = 0; w < words; ++w) {
+                netlist.setInputWord(values.data(), words, j, w, exhaustiveInputWord(base + 64 * w, j));
+            }
+        }
+        netlist.simulate(values.data(), words, kernels);
+        for (size_t w = 0; w < words && 64 * w < numPatterns; ++w) {
+            const uint64_t valid = validLaneMask(numPatterns, w);
+            for (size_t k = 0; k < numOutputs; ++k) {
+                const uint64_t word = values[netlist.outputIds[k] * words + w] & valid;
+                summary.onesPerOutput[k] += countSetLanes(word);
+                signature = (signature ^ word) * 1099511628211ULL;
+                signature ^= signature >> 29;
+            }
+        }
+    }
+    summary.signature = signature;
+}
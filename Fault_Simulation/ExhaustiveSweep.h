@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "CompiledNetlist.h"
+#include "PatternKernels.h"
+
+// Response summary of one chunk of an exhaustive sweep.
+struct SweepChunkSummary {
+    uint64_t chunk = 0;
+    uint64_t firstPattern = 0;
+    uint64_t numPatterns = 0;
+    // Number of input combinations in the chunk for which primary output k is 1.
+    std::vector<uint64_t> onesPerOutput;
+    // Order-dependent hash of the chunk's output words; equal responses give equal signatures.
+    uint64_t signature = 0;
+};
+
+// Simulates all 2^n input combinations of a compiled netlist with up to 63 inputs without storing responses.
+// The input space is split into chunks of 2^chunkBits consecutive combinations that worker threads simulate
+// independently, 64 combinations per word. Each chunk is reduced to a summary (ones count per output and a
+// signature), and the summaries are handed out in chunk order. A run covers any range of chunks, so an
+// interrupted sweep resumes at the chunk after the last one reported.
+class ExhaustiveSweep {
+public:
+    typedef std::function<void(const SweepChunkSummary& summary)> ChunkHandler;
+
+    static const size_t MaxInputs = 63;
+
+    ExhaustiveSweep(const CompiledNetlist& netlist, const PatternKernels& kernels);
+
+    void setThreadCount(size_t threads);
+    void setChunkBits(unsigned bits);
+
+    uint64_t getNumPatterns() const { return uint64_t(1) << netlist.inputIds.size(); }
+    uint64_t getChunkPatterns() const;
+    uint64_t getNumChunks() const { return getNumPatterns() / getChunkPatterns(); }
+
+    bool run(uint64_t firstChunk, uint64_t endChunk, const ChunkHandler& handler);
+
+    // Totals over the chunks of the last run.
+    const std::vector<uint64_t>& getOnesPerOutput() const { return onesPerOutput; }
+    uint64_t getPatternsSimulated() const { return patternsSimulated; }
+
+private:
+    void simulateChunk(std::vector<uint64_t>& values, SweepChunkSummary& summary) const;
+
+    const CompiledNetlist& netlist;
+    const PatternKernels& kernels;
+    size_t numThreads;
+    unsigned chunkBits;
+
+    std::vector<uint64_t> onesPerOutput;
+    uint64_t patternsSimulated;
+};
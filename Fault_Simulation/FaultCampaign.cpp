@@ -0,0 +1,404 @@
+#include "FaultCampaign.h"
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include "Instrumentation.h"
+
+const uint64_t FaultGrade::NotDetected;
+
+FaultCampaign::FaultCampaign(const CompiledNetlist& netlist, const PatternKernels& kernels, FaultSimulator::Engine engine)
+    : netlist(netlist),
+      kernels(kernels),
+      engine(engine),
+      detectionLimit(1),
+      numThreads(1),
+      coveragePatience(0),
+      threeValued(false),
+      criticalPathTracing(false),
+      initialWords(0),
+      patternsApplied(0),
+      lastNewDetection(0)
+{
+
+}
+
+// Sets how many detecting patterns a fault needs before it is dropped (N-detect); 1 drops on first detection.
+void FaultCampaign::setDetectionLimit(uint64_t limit) {
+    detectionLimit = std::max<uint64_t>(limit, 1);
+}
+
+// Appends faults to the campaign; they start out active and undetected.
+void FaultCampaign::addFaults(const std::vector<StuckAtFault>& newFaults) {
+    for (const StuckAtFault& fault : newFaults) {
+        activeFaults.push_back(static_cast<uint32_t>(faults.size()));
+        faults.push_back(fault);
+        grades.push_back(FaultGrade());
+    }
+}
+
+// Ends a run once 'patterns' consecutive patterns detected no fault for the first time (checked after every
+// block); 0 keeps running until the pattern budget is used up.
+void FaultCampaign::setCoveragePatience(uint64_t patterns) {
+    coveragePatience = patterns;
+}
+
+// Selects three-valued grading: the loader fills dual-rail blocks whose inputs may be X, and a fault is only
+// detected where an output is a definite 0 in one machine and a definite 1 in the other. The parallel-fault
+// engine has no X values, so such a campaign runs on the event-driven engine.
+void FaultCampaign::setThreeValued(bool enabled) {
+    threeValued = enabled;
+}
+
+// Selects critical path tracing for two-valued event-driven campaigns: per block every active fault is resolved
+// to the lanes in which its effect reaches the stem of its fanout-free region, and only those stems are fault
+// simulated, once each, for the lanes in which their flip is observed. Three-valued campaigns keep simulating
+// every fault.
+void FaultCampaign::setCriticalPathTracing(bool enabled) {
+    criticalPathTracing = enabled;
+}
+
+// Turns the campaign into a transition fault campaign: 'loadInitial' fills the first pattern of every pair, the
+// loader passed to run the second one, both for the same pair indices.
+void FaultCampaign::setInitialPatterns(const PatternLoader& loadInitial) {
+    loadInitialPatterns = loadInitial;
+}
+
+// Sets how many worker threads grade the faults of each block; 0 uses one per hardware thread.
+void FaultCampaign::setThreadCount(size_t threads) {
+    if (threads == 0) {
+        threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    numThreads = threads;
+}
+
+// Grades the active faults against patterns 0 .. numPatterns-1, block by block. The campaign ends early once every
+// fault has been dropped or the fault coverage has stopped growing for the coverage patience. Within a block the
+// active faults are split into chunks that the worker threads take from a work-stealing scheduler; every worker
+// owns its simulator and each fault's grade is only written by the chunk holding it, so the grades do not depend
+// on the thread count or the schedule.
+void FaultCampaign::run(const PatternLoader& loadPatterns, size_t numPatterns) {
+    INSTRUMENT_PHASE("faultCampaign");
+    WorkStealingScheduler scheduler(numThreads);
+    patternsApplied = 0;
+    lastNewDetection = 0;
+
+    if (engine == FaultSimulator::PARALLEL_FAULT && !threeValued) {
+        std::vector<std::unique_ptr<ParallelFaultSimulator>> simulators;
+        for (size_t i = 0; i < numThreads; ++i) {
+            simulators.emplace_back(new ParallelFaultSimulator(netlist));
+        }
+        std::vector<uint64_t> values(netlist.getValueArraySize(1), 0);
+        for (size_t base = 0; base < numPatterns && !activeFaults.empty(); base += 64) {
+            const size_t patternsInBlock = std::min<size_t>(64, numPatterns - base);
+            loadPatterns(values.data(), 1, base, patternsInBlock);
+            simulateInitialBlock(1, base, patternsInBlock);
+            const size_t chunkSize = getChunkSize(ParallelFaultSimulator::FaultsPerPass);
+            scheduler.run((activeFaults.size() + chunkSize - 1) / chunkSize, [&](size_t worker, size_t chunk) {
+                const size_t first = chunk * chunkSize;
+                const size_t count = std::min(chunkSize, activeFaults.size() - first);
+                gradeChunkParallelFault(*simulators[worker], values, base, patternsInBlock, &activeFaults[first], count);
+            });
+            if (!finishBlock(base, patternsInBlock)) {
+                break;
+            }
+        }
+        return;
+    }
+
+    if (engine == FaultSimulator::DEDUCTIVE && !threeValued) {
+        // Each worker grades whole patterns of the block against every active fault; the detections are booked
+        // in pattern order afterwards, so a fault is dropped at the same pattern whatever the schedule.
+        std::vector<std::unique_ptr<DeductiveFaultSimulator>> simulators;
+        for (size_t i = 0; i < numThreads; ++i) {
+            simulators.emplace_back(new DeductiveFaultSimulator(netlist));
+        }
+        std::vector<uint64_t> values(netlist.getValueArraySize(1), 0);
+        std::vector<StuckAtFault> blockFaults;
+        std::vector<std::vector<uint32_t>> laneDetections(64);
+        std::vector<size_t> workerBlock(numThreads, 0);
+        for (size_t base = 0; base < numPatterns && !activeFaults.empty(); base += 64) {
+            const size_t patternsInBlock = std::min<size_t>(64, numPatterns - base);
+            loadPatterns(values.data(), 1, base, patternsInBlock);
+            netlist.simulate(values.data(), 1, getPatternKernels(PatternKernels::SCALAR));
+            simulateInitialBlock(1, base, patternsInBlock);
+            blockFaults.clear();
+            for (uint32_t fault : activeFaults) {
+                blockFaults.push_back(faults[fault]);
+            }
+            scheduler.run(patternsInBlock, [&](size_t worker, size_t lane) {
+                DeductiveFaultSimulator& simulator = *simulators[worker];
+                if (workerBlock[worker] != base + 1) {
+                    simulator.loadFaults(blockFaults.data(), blockFaults.size());
+                    workerBlock[worker] = base + 1;
+                }
+                simulator.simulatePattern(values.data(), lane, laneDetections[lane]);
+            });
+            for (size_t lane = 0; lane < patternsInBlock; ++lane) {
+                recordPatternDetections(laneDetections[lane], base, lane);
+            }
+            if (!finishBlock(base, patternsInBlock)) {
+                break;
+            }
+        }
+        return;
+    }
+
+    // The good machine is simulated once per block; each worker copies it before its first chunk of the block.
+    FaultSimulator goodSimulator(netlist, kernels, threeValued);
+    const size_t words = goodSimulator.getBlockWords();
+    const size_t blockPatterns = 64 * words;
+    const size_t valueWords = goodSimulator.getValueArraySize();
+    std::vector<std::unique_ptr<FaultSimulator>> simulators;
+    for (size_t i = 0; i < numThreads; ++i) {
+        simulators.emplace_back(new FaultSimulator(netlist, kernels, threeValued));
+    }
+    std::vector<size_t> workerBlock(numThreads, 0);
+    const bool tracing = criticalPathTracing && !threeValued;
+    std::unique_ptr<CriticalPathTracer> tracer;
+    if (tracing) {
+        tracer.reset(new CriticalPathTracer(netlist));
+        stemObserved.assign(valueWords, 0);
+        criticality.assign(valueWords, 0);
+        stemQueued.assign(netlist.getNumWires(), 0);
+    }
+    for (size_t base = 0; base < numPatterns && !activeFaults.empty(); base += blockPatterns) {
+        const size_t patternsInBlock = std::min(blockPatterns, numPatterns - base);
+        loadPatterns(goodSimulator.getGoodValues(), words, base, patternsInBlock);
+        goodSimulator.simulateGood();
+        simulateInitialBlock(words, base, patternsInBlock);
+        if (tracing) {
+            // The stem simulations run on the workers, which hold their own copy of the good machine.
+            for (std::unique_ptr<FaultSimulator>& simulator : simulators) {
+                std::copy(goodSimulator.getGoodValues(), goodSimulator.getGoodValues() + valueWords,
+                          simulator->getGoodValues());
+            }
+            gradeBlockByTracing(scheduler, simulators, *tracer, goodSimulator.getGoodValues(), words,
+                                base, patternsInBlock);
+            if (!finishBlock(base, patternsInBlock)) {
+                break;
+            }
+            continue;
+        }
+        const size_t chunkSize = getChunkSize(1);
+        scheduler.run((activeFaults.size() + chunkSize - 1) / chunkSize, [&](size_t worker, size_t chunk) {
+            FaultSimulator& simulator = *simulators[worker];
+            if (workerBlock[worker] != base + 1) {
+                std::copy(goodSimulator.getGoodValues(), goodSimulator.getGoodValues() + valueWords,
+                          simulator.getGoodValues());
+                workerBlock[worker] = base + 1;
+            }
+            const size_t first = chunk * chunkSize;
+            const size_t count = std::min(chunkSize, activeFaults.size() - first);
+            gradeChunkEventDriven(simulator, base, patternsInBlock, &activeFaults[first], count);
+        });
+        if (!finishBlock(base, patternsInBlock)) {
+            break;
+        }
+    }
+}
+
+// Number of active faults per scheduler chunk, a multiple of 'granularity'. A single thread grades the whole
+// list as one chunk; with more threads there are about 16 chunks per worker to steal from.
+size_t FaultCampaign::getChunkSize(size_t granularity) const {
+    size_t chunkSize = activeFaults.size();
+    if (numThreads > 1) {
+        chunkSize = std::max<size_t>((activeFaults.size() + 16 * numThreads - 1) / (16 * numThreads), 1);
+    }
+    chunkSize = (chunkSize + granularity - 1) / granularity * granularity;
+    return std::max(chunkSize, granularity);
+}
+
+// Simulates a chunk of faults with the event-driven engine against the good machine of the current block.
+void FaultCampaign::gradeChunkEventDriven(FaultSimulator& simulator, size_t base, size_t numPatterns,
+                                          const uint32_t* chunk, size_t count) {
+    const size_t words = simulator.getBlockWords();
+    std::vector<uint64_t> detectedLanes(words);
+
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t fault = chunk[i];
+        if (simulator.simulateFault(faults[fault], detectedLanes.data())) {
+            recordLanes(fault, detectedLanes.data(), words, base, numPatterns);
+        }
+    }
+}
+
+// Grades the active faults of a block by critical path tracing. The criticality is traced once and every active
+// fault's sensitized lanes are resolved from it; only the stems of the regions with a sensitized fault are then
+// simulated, in chunks by the workers, and each fault is detected where its stem's flip is observed.
+void FaultCampaign::gradeBlockByTracing(WorkStealingScheduler& scheduler,
+                                        std::vector<std::unique_ptr<FaultSimulator>>& simulators,
+                                        const CriticalPathTracer& tracer, const uint64_t* goodValues, size_t words,
+                                        size_t base, size_t numPatterns) {
+    tracer.traceBlock(goodValues, words, criticality.data());
+    sensitizedLanes.resize(activeFaults.size() * words);
+    blockStems.clear();
+    for (size_t i = 0; i < activeFaults.size(); ++i) {
+        const StuckAtFault& fault = faults[activeFaults[i]];
+        uint64_t* lanes = &sensitizedLanes[i * words];
+        tracer.getSensitizedLanes(fault, goodValues, criticality.data(), words, lanes);
+        uint64_t sensitized = 0;
+        for (size_t w = 0; w < words; ++w) {
+            lanes[w] &= validLaneMask(numPatterns, w) & getLaunchLanes(fault, w);
+            sensitized |= lanes[w];
+        }
+        const uint32_t stem = tracer.getFaultStem(fault);
+        if (sensitized && !stemQueued[stem]) {
+            stemQueued[stem] = 1;
+            blockStems.push_back(stem);
+        }
+    }
+
+    const size_t stemChunkSize = std::max<size_t>((blockStems.size() + 16 * numThreads - 1) / (16 * numThreads), 1);
+    scheduler.run((blockStems.size() + stemChunkSize - 1) / stemChunkSize, [&](size_t worker, size_t chunk) {
+        const size_t last = std::min(blockStems.size(), (chunk + 1) * stemChunkSize);
+        for (size_t i = chunk * stemChunkSize; i < last; ++i) {
+            const uint32_t stem = blockStems[i];
+            simulators[worker]->simulateFlip(stem, &stemObserved[stem * words]);
+        }
+    });
+
+    std::vector<uint64_t> detectedLanes(words);
+    for (size_t i = 0; i < activeFaults.size(); ++i) {
+        const uint32_t stem = tracer.getFaultStem(faults[activeFaults[i]]);
+        if (!stemQueued[stem]) {
+            continue;
+        }
+        for (size_t w = 0; w < words; ++w) {
+            detectedLanes[w] = sensitizedLanes[i * words + w] & stemObserved[stem * words + w];
+        }
+        recordLanes(activeFaults[i], detectedLanes.data(), words, base, numPatterns);
+    }
+    for (uint32_t stem : blockStems) {
+        stemQueued[stem] = 0;
+    }
+}
+
+// Books the detecting lanes of a fault in a block, restricted to the block's patterns and launching pairs.
+void FaultCampaign::recordLanes(uint32_t fault, const uint64_t* detectedLanes, size_t words, size_t base,
+                                size_t numPatterns) {
+    uint64_t firstPattern = FaultGrade::NotDetected;
+    uint64_t detections = 0;
+    for (size_t w = 0; w < words; ++w) {
+        const uint64_t lanes = detectedLanes[w] & validLaneMask(numPatterns, w) & getLaunchLanes(faults[fault], w);
+        if (lanes && firstPattern == FaultGrade::NotDetected) {
+            firstPattern = base + 64 * w + lowestSetLane(lanes);
+        }
+        detections += countSetLanes(lanes);
+    }
+    if (detections) {
+        recordDetections(fault, firstPattern, detections);
+    }
+}
+
+// Grades a chunk of faults pattern by pattern, 63 faults per pass. Faults of the chunk are dropped after every
+// pattern, so its groups shrink as the block proceeds.
+void FaultCampaign::gradeChunkParallelFault(ParallelFaultSimulator& simulator, const std::vector<uint64_t>& values,
+                                            size_t base, size_t numPatterns, const uint32_t* chunk, size_t count) {
+    std::vector<uint32_t> chunkFaults(chunk, chunk + count);
+    std::vector<bool> inputValues(netlist.inputIds.size());
+    std::vector<StuckAtFault> group;
+
+    for (size_t lane = 0; lane < numPatterns && !chunkFaults.empty(); ++lane) {
+        for (size_t j = 0; j < netlist.inputIds.size(); ++j) {
+            inputValues[j] = (values[netlist.inputIds[j]] >> lane) & 1;
+        }
+        for (size_t first = 0; first < chunkFaults.size(); first += ParallelFaultSimulator::FaultsPerPass) {
+            const size_t groupSize = std::min(ParallelFaultSimulator::FaultsPerPass, chunkFaults.size() - first);
+            group.clear();
+            for (size_t i = 0; i < groupSize; ++i) {
+                group.push_back(faults[chunkFaults[first + i]]);
+            }
+            simulator.loadFaults(group.data(), groupSize);
+            const uint64_t detected = simulator.simulatePattern(inputValues);
+            for (size_t i = 0; i < groupSize; ++i) {
+                if (((detected >> (i + 1)) & 1) && ((getLaunchLanes(group[i], 0) >> lane) & 1)) {
+                    recordDetections(chunkFaults[first + i], base + lane, 1);
+                }
+            }
+        }
+        chunkFaults.erase(std::remove_if(chunkFaults.begin(), chunkFaults.end(),
+                                         [this](uint32_t fault) { return grades[fault].detections >= detectionLimit; }),
+                          chunkFaults.end());
+    }
+}
+
+// Books the faults a deductive pass detected in pattern 'lane' of the block (indices into the active list), skipping
+// the faults that reached the detection limit at an earlier pattern of the block and the pairs that do not launch.
+void FaultCampaign::recordPatternDetections(const std::vector<uint32_t>& detected, size_t base, size_t lane) {
+    for (uint32_t index : detected) {
+        const uint32_t fault = activeFaults[index];
+        if (grades[fault].detections < detectionLimit && ((getLaunchLanes(faults[fault], 0) >> lane) & 1)) {
+            recordDetections(fault, base + lane, 1);
+        }
+    }
+}
+
+// Simulates the good machine under the first patterns of the block's transition pairs; nothing for stuck-at
+// campaigns. It shares the compiled netlist with the fault simulation of the second patterns.
+void FaultCampaign::simulateInitialBlock(size_t words, size_t base, size_t numPatterns) {
+    if (!loadInitialPatterns) {
+        return;
+    }
+    if (initialWords != words) {
+        initialWords = words;
+        if (threeValued) {
+            initialValues.assign(netlist.getDualRailArraySize(words), 0);
+            netlist.clearDualRail(initialValues.data(), words);
+        } else {
+            initialValues.assign(netlist.getValueArraySize(words), 0);
+        }
+    }
+    // The parallel-fault engine works on single-word blocks.
+    const PatternKernels& blockKernels = words == kernels.blockWords ? kernels : getPatternKernels(PatternKernels::SCALAR);
+    loadInitialPatterns(initialValues.data(), words, base, numPatterns);
+    if (threeValued) {
+        netlist.simulateDualRail(initialValues.data(), words, blockKernels);
+    } else {
+        netlist.simulate(initialValues.data(), words, blockKernels);
+    }
+}
+
+// Lanes of block word 'wordIndex' that launch the fault's transition: those whose first pattern holds the stuck
+// value at the fault site (a definite one in three-valued campaigns). All lanes for stuck-at campaigns.
+uint64_t FaultCampaign::getLaunchLanes(const StuckAtFault& fault, size_t wordIndex) const {
+    if (!loadInitialPatterns) {
+        return ~uint64_t(0);
+    }
+    if (threeValued) {
+        const uint64_t* site = &initialValues[2 * fault.wire * initialWords];
+        return fault.value ? site[wordIndex] : site[initialWords + wordIndex];
+    }
+    const uint64_t site = initialValues[fault.wire * initialWords + wordIndex];
+    return fault.value ? site : ~site;
+}
+
+// Adds 'count' detecting patterns to a fault's grade; 'firstPattern' is the earliest of them.
+void FaultCampaign::recordDetections(uint32_t fault, uint64_t firstPattern, uint64_t count) {
+    FaultGrade& grade = grades[fault];
+    grade.firstDetection = std::min(grade.firstDetection, firstPattern);
+    grade.detections += count;
+}
+
+// Books a graded block and drops its detected faults. Returns false once the coverage has not grown for
+// the coverage patience.
+bool FaultCampaign::finishBlock(uint64_t base, size_t numPatterns) {
+    patternsApplied = base + numPatterns;
+    INSTRUMENT_COUNT(PATTERNS, numPatterns);
+    for (uint32_t fault : activeFaults) {
+        const uint64_t firstDetection = grades[fault].firstDetection;
+        if (firstDetection != FaultGrade::NotDetected && firstDetection >= base) {
+            lastNewDetection = std::max(lastNewDetection, firstDetection + 1);
+        }
+    }
+    dropDetectedFaults();
+    return coveragePatience == 0 || patternsApplied - lastNewDetection < coveragePatience;
+}
+
+// Removes the faults that reached the detection limit from the active list, keeping the list order.
+void FaultCampaign::dropDetectedFaults() {
+    const size_t numActive = activeFaults.size();
+    activeFaults.erase(std::remove_if(activeFaults.begin(), activeFaults.end(),
+                                      [this](uint32_t fault) { return grades[fault].detections >= detectionLimit; }),
+                       activeFaults.end());
+    INSTRUMENT_COUNT(FAULTS_DROPPED, numActive - activeFaults.size());
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "CompiledNetlist.h"
+#include "CriticalPathTracer.h"
+#include "DeductiveFaultSimulator.h"
+#include "FaultSimulator.h"
+#include "ParallelFaultSimulator.h"
+#include "PatternKernels.h"
+#include "WorkStealingScheduler.h"
+
+// Detection result of one fault in a campaign.
+struct FaultGrade {
+    static const uint64_t NotDetected = ~0ULL;
+
+    uint64_t firstDetection = NotDetected; // Index of the first detecting pattern.
+    uint64_t detections = 0;               // Number of detecting patterns seen before the fault was dropped.
+};
+
+// Drives a stuck-at fault campaign over a stream of pattern blocks with one of the compiled engines.
+// Outputs are compared block by block as they are produced, and a fault is dropped from the active list
+// as soon as it reaches the detection limit (1 by default, higher for N-detect grading), so later blocks
+// only simulate the faults that are still undetected. The faults of a block can be graded by several threads.
+// With a coverage patience the campaign also ends once that many patterns in a row detected no new fault.
+// The deductive engine grades pattern by pattern, every active fault in one pass per pattern.
+// A three-valued campaign grades patterns with X inputs on the event-driven engine. A transition campaign grades
+// pattern pairs: each fault is read as the transition away from its stuck value (stuck-at-0 as slow-to-rise,
+// stuck-at-1 as slow-to-fall), simulated as that stuck-at fault under the second pattern and only counted in the
+// pairs whose first pattern holds the stuck value at the fault site, so the site toggles in the slow direction.
+// With critical path tracing a two-valued event-driven campaign only simulates the stems of the fanout-free
+// regions whose faults reach them and resolves the faults inside the regions from the good values.
+class FaultCampaign {
+public:
+    // Fills the primary input words of the pattern block starting at pattern 'base' into a dense value array,
+    // or with CompiledNetlist::setInputRails into a dual-rail array in a three-valued campaign.
+    typedef std::function<void(uint64_t* values, size_t words, size_t base, size_t numPatterns)> PatternLoader;
+
+    FaultCampaign(const CompiledNetlist& netlist, const PatternKernels& kernels, FaultSimulator::Engine engine);
+
+    void setDetectionLimit(uint64_t limit);
+    void setThreadCount(size_t threads);
+    void setCoveragePatience(uint64_t patterns);
+    void setThreeValued(bool enabled);
+    void setCriticalPathTracing(bool enabled);
+    void setInitialPatterns(const PatternLoader& loadInitial);
+    void addFaults(const std::vector<StuckAtFault>& newFaults);
+    void run(const PatternLoader& loadPatterns, size_t numPatterns);
+
+    const std::vector<FaultGrade>& getGrades() const { return grades; }
+    size_t getNumActiveFaults() const { return activeFaults.size(); }
+    // Number of patterns the last run simulated before it ended.
+    uint64_t getPatternsApplied() const { return patternsApplied; }
+
+private:
+    size_t getChunkSize(size_t granularity) const;
+    void gradeChunkEventDriven(FaultSimulator& simulator, size_t base, size_t numPatterns,
+                               const uint32_t* chunk, size_t count);
+    void gradeChunkParallelFault(ParallelFaultSimulator& simulator, const std::vector<uint64_t>& values,
+                                 size_t base, size_t numPatterns, const uint32_t* chunk, size_t count);
+    void gradeBlockByTracing(WorkStealingScheduler& scheduler, std::vector<std::unique_ptr<FaultSimulator>>& simulators,
+                             const CriticalPathTracer& tracer, const uint64_t* goodValues, size_t words,
+                             size_t base, size_t numPatterns);
+    void recordLanes(uint32_t fault, const uint64_t* detectedLanes, size_t words, size_t base, size_t numPatterns);
+    void recordPatternDetections(const std::vector<uint32_t>& detected, size_t base, size_t lane);
+    void simulateInitialBlock(size_t words, size_t base, size_t numPatterns);
+    uint64_t getLaunchLanes(const StuckAtFault& fault, size_t wordIndex) const;
+    void recordDetections(uint32_t fault, uint64_t firstPattern, uint64_t count);
+    void dropDetectedFaults();
+    bool finishBlock(uint64_t base, size_t numPatterns);
+
+    const CompiledNetlist& netlist;
+    const PatternKernels& kernels;
+    FaultSimulator::Engine engine;
+    uint64_t detectionLimit;
+    size_t numThreads;
+    uint64_t coveragePatience;
+    bool threeValued;
+    bool criticalPathTracing;
+    // Flip observability of the stems in the current block, the criticality of every wire for its stem, the
+    // sensitized lanes of the active faults and the stems simulated for them.
+    std::vector<uint64_t> stemObserved;
+    std::vector<uint64_t> criticality;
+    std::vector<uint64_t> sensitizedLanes;
+    std::vector<uint32_t> blockStems;
+    std::vector<uint8_t> stemQueued;
+    // Loader of the first patterns of transition pairs (empty for stuck-at campaigns), and the good values of
+    // the current block's first patterns with their words per lane block.
+    PatternLoader loadInitialPatterns;
+    std::vector<uint64_t> initialValues;
+    size_t initialWords;
+    uint64_t patternsApplied;
+    // One past the last pattern that detected a fault for the first time.
+    uint64_t lastNewDetection;
+
+    std::vector<StuckAtFault> faults;
+    std::vector<FaultGrade> grades;
+    // Indices into 'faults' of the faults that still need simulation, in fault list order.
+    std::vector<uint32_t> activeFaults;
+};
@@ -0,0 +1,317 @@
+#include "FaultList.h"
+#include <algorithm>
+
+const uint32_t FaultList::NoNode;
+
+FaultList::FaultList()
+    : netlist(nullptr)
+{
+
+}
+
+// Returns the number of input pins a gate really reads; NOT and BUFFER never look at their second input.
+static uint8_t gatePinCount(const CompiledNetlist& netlist, uint32_t gate) {
+    const uint8_t type = netlist.gateType[gate];
+    return (type == Gate::AND || type == Gate::OR) ? 2 : 1;
+}
+
+static uint32_t gatePinWire(const CompiledNetlist& netlist, uint32_t gate, uint8_t pin) {
+    return pin == 0 ? netlist.gateInput1[gate] : netlist.gateInput2[gate];
+}
+
+// Enumerates the faults: both stuck-at values on the stem of each wire in 'stemWires', in that order, each
+// followed by the branch faults of the wire if 'includeBranches' is set. A wire has branches when more than
+// one gate pin reads it or when a gate pin reads it besides it being a primary output; a single reader's
+// pin faults are the stem faults. Every fault starts out as its own representative, unless the optimizer
+// resolves several faults onto the same fault of the compiled netlist, which then represents all of them.
+void FaultList::build(const CompiledNetlist& compiled, const std::vector<uint32_t>& stemWires, bool includeBranches,
+                      const NetlistOptimizer* optimizer) {
+    netlist = &compiled;
+    const size_t numWires = compiled.getNumWires();
+    const uint32_t numGates = static_cast<uint32_t>(compiled.getNumGates());
+
+    // Gate pins reading each wire in compressed form, pins encoded as 2 * gate + pin.
+    std::vector<uint32_t> pinStart(numWires + 1, 0);
+    for (uint32_t g = 0; g < numGates; ++g) {
+        for (uint8_t pin = 0; pin < gatePinCount(compiled, g); ++pin) {
+            const uint32_t wire = gatePinWire(compiled, g, pin);
+            if (wire != compiled.zeroWire) {
+                ++pinStart[wire + 1];
+            }
+        }
+    }
+    for (size_t w = 0; w < numWires; ++w) {
+        pinStart[w + 1] += pinStart[w];
+    }
+    std::vector<uint32_t> pins(pinStart[numWires]);
+    std::vector<uint32_t> fill(pinStart.begin(), pinStart.end() - 1);
+    for (uint32_t g = 0; g < numGates; ++g) {
+        for (uint8_t pin = 0; pin < gatePinCount(compiled, g); ++pin) {
+            const uint32_t wire = gatePinWire(compiled, g, pin);
+            if (wire != compiled.zeroWire) {
+                pins[fill[wire]++] = 2 * g + pin;
+            }
+        }
+    }
+
+    // Stem nodes come first (two per wire), then two nodes per branch.
+    branchNodes.assign(2 * size_t(numGates), NoNode);
+    uint32_t numNodes = static_cast<uint32_t>(2 * numWires);
+    for (size_t w = 0; w < numWires; ++w) {
+        const uint32_t readers = pinStart[w + 1] - pinStart[w];
+        if (readers + (compiled.isOutput[w] ? 1 : 0) > 1) {
+            for (uint32_t i = pinStart[w]; i < pinStart[w + 1]; ++i) {
+                branchNodes[pins[i]] = numNodes;
+                numNodes += 2;
+            }
+        }
+    }
+    parent.resize(numNodes);
+    for (uint32_t node = 0; node < numNodes; ++node) {
+        parent[node] = node;
+    }
+
+    faults.clear();
+    simulatedFaults.clear();
+    faultNodes.clear();
+    for (uint32_t wire : stemWires) {
+        for (int value = 0; value <= 1; ++value) {
+            faults.push_back({ wire, value != 0 });
+            StuckAtFault simulated = faults.back();
+            if (!optimizer || optimizer->resolveFault(faults.back(), simulated)) {
+                faultNodes.push_back(stemNode(simulated.wire, simulated.value));
+            } else {
+                faultNodes.push_back(NoNode);
+            }
+            simulatedFaults.push_back(simulated);
+        }
+        if (!includeBranches) {
+            continue;
+        }
+        for (uint32_t i = pinStart[wire]; i < pinStart[wire + 1]; ++i) {
+            const uint32_t gate = pins[i] / 2;
+            const uint8_t pin = static_cast<uint8_t>(pins[i] % 2);
+            if (branchNodes[pins[i]] == NoNode) {
+                continue;
+            }
+            for (int value = 0; value <= 1; ++value) {
+                StuckAtFault fault = { wire, value != 0 };
+                fault.gate = gate;
+                fault.pin = pin;
+                faults.push_back(fault);
+                simulatedFaults.push_back(fault);
+                faultNodes.push_back(pinNode(gate, pin, value != 0));
+            }
+        }
+    }
+
+    std::vector<uint32_t> nodeRepresentative(numNodes, NoNode);
+    representatives.clear();
+    droppedByDominance.assign(faults.size(), 0);
+    gradeSources.assign(faults.size(), std::vector<uint32_t>());
+    for (size_t i = 0; i < faults.size(); ++i) {
+        if (faultNodes[i] == NoNode) {
+            continue;
+        }
+        uint32_t& representative = nodeRepresentative[faultNodes[i]];
+        if (representative == NoNode) {
+            representative = static_cast<uint32_t>(representatives.size());
+            representatives.push_back(simulatedFaults[i]);
+        }
+        gradeSources[i].push_back(representative);
+    }
+}
+
+// Collapses the list built last. EQUIVALENCE keeps one representative per equivalence class;
+// DOMINANCE additionally drops the gate output faults that dominate one of their input faults.
+void FaultList::collapse(Collapsing mode) {
+    if (mode == NO_COLLAPSING || !netlist) {
+        return;
+    }
+    collapseEquivalent();
+
+    // The first listed fault of each class becomes its representative.
+    std::vector<uint32_t> classRepresentative(parent.size(), NoNode);
+    representatives.clear();
+    for (size_t i = 0; i < faults.size(); ++i) {
+        if (faultNodes[i] == NoNode) {
+            continue;
+        }
+        uint32_t& representative = classRepresentative[findClass(faultNodes[i])];
+        if (representative == NoNode) {
+            representative = static_cast<uint32_t>(representatives.size());
+            representatives.push_back(simulatedFaults[i]);
+        }
+        gradeSources[i].assign(1, representative);
+    }
+
+    if (mode == DOMINANCE) {
+        collapseDominated();
+    }
+}
+
+// Merges the faults of each gate that produce the same faulty function, following what the compiled gate
+// computes: out = type(in1 ^ neg1, in2 ^ neg2). A pin stuck at the value that makes its effective input
+// controlling (0 for AND, 1 for OR) is equivalent to the output stuck at the controlled value, and every
+// pin fault of a single-input gate is equivalent to an output fault. This includes the buffer behaviour
+// of a NOT gate whose input is negated.
+void FaultList::collapseEquivalent() {
+    const uint32_t numGates = static_cast<uint32_t>(netlist->getNumGates());
+    for (uint32_t g = 0; g < numGates; ++g) {
+        const uint32_t output = netlist->gateOutput[g];
+        const bool neg[2] = { netlist->negInput1[g] != 0, netlist->negInput2[g] != 0 };
+        for (uint8_t pin = 0; pin < gatePinCount(*netlist, g); ++pin) {
+            if (gatePinWire(*netlist, g, pin) == netlist->zeroWire) {
+                continue;
+            }
+            switch (netlist->gateType[g]) {
+                case Gate::AND:
+                    unite(pinNode(g, pin, neg[pin]), stemNode(output, false));
+                    break;
+                case Gate::OR:
+                    unite(pinNode(g, pin, !neg[pin]), stemNode(output, true));
+                    break;
+                case Gate::NOT:
+                    for (int value = 0; value <= 1; ++value) {
+                        unite(pinNode(g, pin, value != 0), stemNode(output, !((value != 0) != neg[pin])));
+                    }
+                    break;
+                case Gate::BUFFER:
+                    for (int value = 0; value <= 1; ++value) {
+                        unite(pinNode(g, pin, value != 0), stemNode(output, (value != 0) != neg[pin]));
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+// Drops dominating faults: any pattern detecting an AND pin stuck at its non-controlling value also
+// detects the output stuck-at-1 (output stuck-at-0 for OR), so the output fault needs no simulation of its
+// own and is graded from its dominated faults. Gates are visited from the outputs back, and a class that
+// grades another one is never dropped itself, so a dropped fault always rests on simulated faults.
+// This is the usual dominance collapsing: a dominating fault whose dominated faults are all undetectable
+// is reported undetected even if some pattern could detect it.
+void FaultList::collapseDominated() {
+    std::vector<uint32_t> classRepresentative(parent.size(), NoNode);
+    for (size_t i = 0; i < faults.size(); ++i) {
+        if (faultNodes[i] != NoNode) {
+            classRepresentative[findClass(faultNodes[i])] = gradeSources[i][0];
+        }
+    }
+    std::vector<uint8_t> pinned(representatives.size(), 0);
+    std::vector<std::vector<uint32_t>> dominatedBy(representatives.size());
+    std::vector<uint8_t> dropped(representatives.size(), 0);
+
+    const uint32_t numGates = static_cast<uint32_t>(netlist->getNumGates());
+    for (uint32_t g = numGates; g-- > 0;) {
+        const uint8_t type = netlist->gateType[g];
+        if (type != Gate::AND && type != Gate::OR) {
+            continue;
+        }
+        const bool controlling = type == Gate::OR;
+        const uint32_t dominating = classRepresentative[findClass(stemNode(netlist->gateOutput[g], !controlling))];
+        if (dominating == NoNode || pinned[dominating] || dropped[dominating]) {
+            continue;
+        }
+        const bool neg[2] = { netlist->negInput1[g] != 0, netlist->negInput2[g] != 0 };
+        std::vector<uint32_t> sources;
+        for (uint8_t pin = 0; pin < 2; ++pin) {
+            if (gatePinWire(*netlist, g, pin) == netlist->zeroWire) {
+                continue;
+            }
+            const uint32_t dominated = classRepresentative[findClass(pinNode(g, pin, controlling == neg[pin]))];
+            if (dominated != NoNode && dominated != dominating && !dropped[dominated]) {
+                sources.push_back(dominated);
+            }
+        }
+        if (sources.empty()) {
+            continue;
+        }
+        for (uint32_t source : sources) {
+            pinned[source] = 1;
+        }
+        dropped[dominating] = 1;
+        dominatedBy[dominating] = sources;
+    }
+
+    // Renumber the surviving representatives and point every fault at its new grade sources.
+    std::vector<uint32_t> newIndex(representatives.size(), NoNode);
+    std::vector<StuckAtFault> kept;
+    for (size_t r = 0; r < representatives.size(); ++r) {
+        if (!dropped[r]) {
+            newIndex[r] = static_cast<uint32_t>(kept.size());
+            kept.push_back(representatives[r]);
+        }
+    }
+    for (size_t i = 0; i < faults.size(); ++i) {
+        if (faultNodes[i] == NoNode) {
+            continue;
+        }
+        const uint32_t representative = gradeSources[i][0];
+        if (!dropped[representative]) {
+            gradeSources[i].assign(1, newIndex[representative]);
+            continue;
+        }
+        gradeSources[i].clear();
+        droppedByDominance[i] = 1;
+        for (uint32_t source : dominatedBy[representative]) {
+            gradeSources[i].push_back(newIndex[source]);
+        }
+    }
+    representatives.swap(kept);
+}
+
+// Maps the grades of the simulated representatives onto every fault of the list. A fault graded from
+// several dominated faults takes the earliest first detection and the largest detection count among them.
+std::vector<FaultGrade> FaultList::expandGrades(const std::vector<FaultGrade>& representativeGrades) const {
+    std::vector<FaultGrade> grades(faults.size());
+    for (size_t i = 0; i < faults.size(); ++i) {
+        for (uint32_t source : gradeSources[i]) {
+            const FaultGrade& grade = representativeGrades[source];
+            grades[i].firstDetection = std::min(grades[i].firstDetection, grade.firstDetection);
+            grades[i].detections = std::max(grades[i].detections, grade.detections);
+        }
+    }
+    return grades;
+}
+
+// Maps the representatives proven redundant onto every fault of the list. An equivalent fault is redundant
+// with its representative; a fault dropped by dominance is never marked, since redundant dominated faults
+// say nothing about the fault that dominates them.
+std::vector<uint8_t> FaultList::expandRedundant(const std::vector<uint8_t>& representativeRedundant) const {
+    std::vector<uint8_t> redundant(faults.size(), 0);
+    for (size_t i = 0; i < faults.size(); ++i) {
+        if (!droppedByDominance[i] && !gradeSources[i].empty()) {
+            redundant[i] = representativeRedundant[gradeSources[i][0]];
+        }
+    }
+    return redundant;
+}
+
+// Union-find node of a gate pin stuck at 'value': its branch node, or the stem node of a fanout-free wire.
+uint32_t FaultList::pinNode(uint32_t gate, uint8_t pin, bool value) const {
+    const uint32_t branch = branchNodes[2 * gate + pin];
+    if (branch != NoNode) {
+        return branch + (value ? 1 : 0);
+    }
+    return stemNode(gatePinWire(*netlist, gate, pin), value);
+}
+
+uint32_t FaultList::findClass(uint32_t node) {
+    while (parent[node] != node) {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+void FaultList::unite(uint32_t a, uint32_t b) {
+    a = findClass(a);
+    b = findClass(b);
+    if (a != b) {
+        parent[std::max(a, b)] = std::min(a, b);
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CompiledNetlist.h"
+#include "FaultSimulator.h"
+#include "FaultCampaign.h"
+#include "NetlistOptimizer.h"
+
+// The stuck-at fault universe of a compiled netlist and its structural collapsing.
+// Faults come in pairs (stuck-at-0, stuck-at-1) per site: the stem of every listed wire and, optionally,
+// each gate pin reading a wire that fans out to more than one place (a branch). Collapsing merges faults
+// that no pattern can tell apart into equivalence classes and, optionally, drops faults that are detected
+// whenever a fault they dominate is. Only the representatives are simulated; expandGrades maps their
+// grades back onto the full list, so reports keep listing every fault.
+// For an optimized netlist the faults keep their original wires, while the representatives are the faults they
+// resolve to in the optimized netlist; a fault that resolves to nothing has no representative and is never detected.
+class FaultList {
+public:
+    enum Collapsing { NO_COLLAPSING, EQUIVALENCE, DOMINANCE };
+
+    FaultList();
+
+    void build(const CompiledNetlist& netlist, const std::vector<uint32_t>& stemWires, bool includeBranches,
+               const NetlistOptimizer* optimizer = nullptr);
+    void collapse(Collapsing mode);
+
+    const std::vector<StuckAtFault>& getFaults() const { return faults; }
+    const std::vector<StuckAtFault>& getRepresentatives() const { return representatives; }
+    std::vector<FaultGrade> expandGrades(const std::vector<FaultGrade>& representativeGrades) const;
+    std::vector<uint8_t> expandRedundant(const std::vector<uint8_t>& representativeRedundant) const;
+
+private:
+    static const uint32_t NoNode = 0xFFFFFFFFu;
+
+    uint32_t stemNode(uint32_t wire, bool value) const { return 2 * wire + (value ? 1 : 0); }
+    uint32_t pinNode(uint32_t gate, uint8_t pin, bool value) const;
+    uint32_t findClass(uint32_t node);
+    void unite(uint32_t a, uint32_t b);
+    void collapseEquivalent();
+    void collapseDominated();
+
+    const CompiledNetlist* netlist;
+    std::vector<StuckAtFault> faults;
+    // Each fault as it is simulated on the compiled netlist.
+    std::vector<StuckAtFault> simulatedFaults;
+    // Union-find node of each simulated fault, NoNode for a fault without one. Nodes cover every possible
+    // fault of the netlist, listed or not, so equivalences also chain through faults the list leaves out
+    // (e.g. those on primary outputs).
+    std::vector<uint32_t> faultNodes;
+    std::vector<uint32_t> parent;
+    // Per gate pin (2 * gate + pin): the stuck-at-0 node of its branch, or NoNode if the pin reads a
+    // fanout-free wire and its faults are the stem faults of that wire.
+    std::vector<uint32_t> branchNodes;
+
+    std::vector<StuckAtFault> representatives;
+    // Per fault: the representatives whose grades make up its grade. An equivalent fault has exactly one;
+    // a fault dropped by dominance has the faults it dominates and counts as detected when any of them is.
+    std::vector<std::vector<uint32_t>> gradeSources;
+    // 1 for the faults dropped by dominance.
+    std::vector<uint8_t> droppedByDominance;
+};
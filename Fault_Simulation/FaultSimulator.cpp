@@ -0,0 +1,170 @@
+#include "FaultSimulator.h"
+#include <algorithm>
+#include "Instrumentation.h"
+
+FaultSimulator::FaultSimulator(const CompiledNetlist& netlist, const PatternKernels& kernels, bool threeValued)
+    : netlist(netlist),
+      kernels(kernels),
+      threeValued(threeValued),
+      words(kernels.blockWords),
+      wireWords(threeValued ? 2 * kernels.blockWords : kernels.blockWords),
+      evaluateGate(threeValued ? kernels.evaluateGateDualRail : kernels.evaluateGate),
+      goodValues(netlist.getNumWires() * wireWords, 0),
+      faultyValues(netlist.getNumWires() * wireWords, 0),
+      wireEpoch(netlist.getNumWires(), 0),
+      gateEpoch(netlist.getNumGates(), 0),
+      epoch(0),
+      levelQueues(netlist.numLevels),
+      lowestPendingLevel(0),
+      highestPendingLevel(0),
+      scratch(wireWords, 0),
+      stuckBlock(wireWords, 0)
+{
+    if (threeValued) {
+        netlist.clearDualRail(goodValues.data(), words);
+    }
+}
+
+// Simulates the fault-free machine for the pattern block whose input words were set in getGoodValues().
+void FaultSimulator::simulateGood() {
+    if (threeValued) {
+        netlist.simulateDualRail(goodValues.data(), words, kernels);
+    } else {
+        netlist.simulate(goodValues.data(), words, kernels);
+    }
+}
+
+// Simulates one stuck-at fault against the current good machine and sets 'detectedLanes' (one word per
+// block word) to the patterns in which at least one primary output differs. Returns whether any lane differs.
+bool FaultSimulator::simulateFault(const StuckAtFault& fault, uint64_t* detectedLanes) {
+    std::fill(detectedLanes, detectedLanes + words, uint64_t(0));
+    startEpoch();
+
+    // The stuck value as a block; in dual-rail form the ones rail is followed by the zeros rail.
+    const uint64_t stuckWord = fault.value ? ~uint64_t(0) : uint64_t(0);
+    std::fill(stuckBlock.begin(), stuckBlock.begin() + words, stuckWord);
+    std::fill(stuckBlock.begin() + words, stuckBlock.end(), ~stuckWord);
+    if (fault.isBranch()) {
+        // A branch fault only changes what its own gate pin reads, so the first event is the output of that
+        // gate, evaluated once with the stuck block in place of the pin's wire.
+        const uint32_t gate = fault.gate;
+        gateEpoch[gate] = epoch;
+        evaluateGate(static_cast<Gate::GateType>(netlist.gateType[gate]),
+                     netlist.negInput1[gate] != 0, netlist.negInput2[gate] != 0,
+                     fault.pin == 0 ? stuckBlock.data() : getGoodBlock(netlist.gateInput1[gate]),
+                     fault.pin == 1 ? stuckBlock.data() : getGoodBlock(netlist.gateInput2[gate]),
+                     scratch.data());
+        if (!postEvent(netlist.gateOutput[gate], detectedLanes)) {
+            return false;
+        }
+    }
+    else {
+        // Activate the fault: only the lanes in which the good value differs from the stuck value carry an event.
+        std::copy(stuckBlock.begin(), stuckBlock.end(), scratch.begin());
+        if (!postEvent(fault.wire, detectedLanes)) {
+            return false;
+        }
+    }
+
+    return propagate(detectedLanes);
+}
+
+// Sets 'observedLanes' to the lanes in which inverting the good value of a wire changes a primary output, the
+// union of the lanes detecting its two stuck-at faults. Returns whether there is any. Two-valued mode only.
+bool FaultSimulator::simulateFlip(uint32_t wire, uint64_t* observedLanes) {
+    std::fill(observedLanes, observedLanes + words, uint64_t(0));
+    startEpoch();
+    const uint64_t* good = getGoodBlock(wire);
+    for (size_t w = 0; w < words; ++w) {
+        scratch[w] = ~good[w];
+    }
+    if (!postEvent(wire, observedLanes)) {
+        return false;
+    }
+    return propagate(observedLanes);
+}
+
+// Evaluates the scheduled gates level by level. A gate whose faulty output equals the good output
+// produces no event, so the propagation stops as soon as the difference dies out.
+bool FaultSimulator::propagate(uint64_t* detectedLanes) {
+    uint64_t evaluations = 0;
+    uint64_t events = 0;
+    for (uint32_t level = lowestPendingLevel; level <= highestPendingLevel && level < levelQueues.size(); ++level) {
+        std::vector<uint32_t>& queue = levelQueues[level];
+        for (size_t q = 0; q < queue.size(); ++q) {
+            const uint32_t gate = queue[q];
+            evaluateGate(static_cast<Gate::GateType>(netlist.gateType[gate]),
+                         netlist.negInput1[gate] != 0, netlist.negInput2[gate] != 0,
+                         currentBlock(netlist.gateInput1[gate]), currentBlock(netlist.gateInput2[gate]),
+                         scratch.data());
+            events += postEvent(netlist.gateOutput[gate], detectedLanes);
+        }
+        evaluations += queue.size();
+        queue.clear();
+    }
+    INSTRUMENT_COUNT(GATE_EVALUATIONS, evaluations);
+    INSTRUMENT_COUNT(EVENTS, events);
+
+    uint64_t detected = 0;
+    for (size_t w = 0; w < words; ++w) {
+        detected |= detectedLanes[w];
+    }
+    return detected != 0;
+}
+
+// Stores the faulty value computed in 'scratch' for a wire if it differs from the good value in any lane,
+// records the detected lanes when the wire is a primary output and schedules its fanout. Returns whether
+// the wire carries an event. In three-valued mode a lane that only changes to or from X is an event but not
+// a detection.
+bool FaultSimulator::postEvent(uint32_t wire, uint64_t* detectedLanes) {
+    const uint64_t* good = getGoodBlock(wire);
+    uint64_t difference = 0;
+    for (size_t w = 0; w < wireWords; ++w) {
+        difference |= scratch[w] ^ good[w];
+    }
+    if (!difference) {
+        return false;
+    }
+
+    std::copy(scratch.begin(), scratch.end(), faultyValues.begin() + wire * wireWords);
+    wireEpoch[wire] = epoch;
+    if (netlist.isOutput[wire]) {
+        for (size_t w = 0; w < words; ++w) {
+            detectedLanes[w] |= threeValued ? (scratch[w] & good[words + w]) | (scratch[words + w] & good[w])
+                                            : scratch[w] ^ good[w];
+        }
+    }
+    scheduleFanout(wire);
+    return true;
+}
+
+// Returns the faulty machine's value of a wire, which is the good value unless an event reached the wire.
+const uint64_t* FaultSimulator::currentBlock(uint32_t wire) const {
+    return wireEpoch[wire] == epoch ? &faultyValues[wire * wireWords] : &goodValues[wire * wireWords];
+}
+
+// Schedules every gate reading the wire for evaluation, at most once per fault.
+void FaultSimulator::scheduleFanout(uint32_t wire) {
+    for (uint32_t i = netlist.fanoutStart[wire]; i < netlist.fanoutStart[wire + 1]; ++i) {
+        const uint32_t gate = netlist.fanoutGates[i];
+        if (gateEpoch[gate] == epoch) {
+            continue;
+        }
+        gateEpoch[gate] = epoch;
+        const uint32_t level = netlist.gateLevel[gate];
+        levelQueues[level].push_back(gate);
+        lowestPendingLevel = std::min(lowestPendingLevel, level);
+        highestPendingLevel = std::max(highestPendingLevel, level);
+    }
+}
+
+// Starts a new fault: bumping the epoch invalidates all faulty values and schedule marks of the previous one.
+void FaultSimulator::startEpoch() {
+    if (++epoch == 0) {
+        std::fill(wireEpoch.begin(), wireEpoch.end(), 0u);
+        std::fill(gateEpoch.begin(), gateEpoch.end(), 0u);
+        epoch = 1;
+    }
+    lowestPendingLevel = static_cast<uint32_t>(levelQueues.size());
+    highestPendingLevel = 0;
+}
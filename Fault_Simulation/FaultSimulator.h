@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CompiledNetlist.h"
+#include "PatternKernels.h"
+
+// A single stuck-at fault on a wire of the compiled netlist. A stem fault (the default) forces the wire
+// everywhere it is read; a branch fault only forces what input pin 'pin' (0 or 1) of gate 'gate' reads.
+struct StuckAtFault {
+    uint32_t wire;
+    bool value;
+    uint32_t gate = CompiledNetlist::NoGate;
+    uint8_t pin = 0;
+
+    bool isBranch() const { return gate != CompiledNetlist::NoGate; }
+};
+
+// Grades stuck-at faults against one pattern block at a time on a shared, read-only compiled netlist.
+// The good machine is simulated once per block; each fault is then simulated concurrently against it by
+// propagating only the events in which the faulty machine differs, level by level through the fault site's
+// fanout cone. Propagation ends as soon as no difference is left, so most faults touch only a few gates.
+// In three-valued mode the machines are simulated in dual-rail form (see CompiledNetlist) so inputs can be X,
+// and a lane only counts as detected where an output is 0 in one machine and 1 in the other.
+class FaultSimulator {
+public:
+    // Fault simulation engines selectable by Circuit::runFaultedSimulation.
+    enum Engine { SERIAL, EVENT_DRIVEN, PARALLEL_FAULT, DEDUCTIVE };
+
+    FaultSimulator(const CompiledNetlist& netlist, const PatternKernels& kernels, bool threeValued = false);
+
+    size_t getBlockWords() const { return words; }
+    bool isThreeValued() const { return threeValued; }
+    // Size of the good value array: a two-valued or a dual-rail array of the block width.
+    size_t getValueArraySize() const { return goodValues.size(); }
+    uint64_t* getGoodValues() { return goodValues.data(); }
+    const uint64_t* getGoodBlock(uint32_t wire) const { return &goodValues[wire * wireWords]; }
+
+    void simulateGood();
+    bool simulateFault(const StuckAtFault& fault, uint64_t* detectedLanes);
+    bool simulateFlip(uint32_t wire, uint64_t* observedLanes);
+
+private:
+    const uint64_t* currentBlock(uint32_t wire) const;
+    bool propagate(uint64_t* detectedLanes);
+    bool postEvent(uint32_t wire, uint64_t* detectedLanes);
+    void scheduleFanout(uint32_t wire);
+    void startEpoch();
+
+    const CompiledNetlist& netlist;
+    const PatternKernels& kernels;
+    bool threeValued;
+    // Lane words per block, and words stored per wire (twice as many in dual-rail form).
+    size_t words;
+    size_t wireWords;
+    void (*evaluateGate)(Gate::GateType type, bool negInput1, bool negInput2,
+                         const uint64_t* input1, const uint64_t* input2, uint64_t* output);
+
+    std::vector<uint64_t> goodValues;
+    // Faulty machine values, valid for a wire only while its epoch equals the current one.
+    std::vector<uint64_t> faultyValues;
+    std::vector<uint32_t> wireEpoch;
+    std::vector<uint32_t> gateEpoch;
+    uint32_t epoch;
+
+    // Pending gate evaluations of the current fault, bucketed by logic level.
+    std::vector<std::vector<uint32_t>> levelQueues;
+    uint32_t lowestPendingLevel;
+    uint32_t highestPendingLevel;
+    std::vector<uint64_t> scratch;
+    std::vector<uint64_t> stuckBlock;
+};
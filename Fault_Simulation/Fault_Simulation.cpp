@@ -1,8 +1,34 @@
 #include <iostream>
+#include <string>
+#include "BenchmarkSuite.h"
 #include "Circuit.h"
+#include "KernelBenchmark.h"
 
 int main(int argc, char* argv[])
 {
+    // "--bench-kernels" reports the gate-evaluation throughput of every supported pattern kernel level.
+    if (argc > 1 && std::string(argv[1]) == "--bench-kernels") {
+        runKernelBenchmark();
+        return 0;
+    }
+    // "--bench-suite [options]" generates random netlists of each size and times parsing, levelization, good and
+    // fault simulation on them, optionally against a baseline report (see parseBenchmarkOptions).
+    if (argc > 1 && std::string(argv[1]) == "--bench-suite") {
+        BenchmarkOptions options;
+        if (!parseBenchmarkOptions(argc, argv, 2, options)) {
+            return 1;
+        }
+        return runBenchmarkSuite(options);
+    }
+    // "--generate-netlist <file> [options]" only writes the random netlist of the first gate count.
+    if (argc > 2 && std::string(argv[1]) == "--generate-netlist") {
+        BenchmarkOptions options;
+        if (!parseBenchmarkOptions(argc, argv, 3, options)) {
+            return 1;
+        }
+        return writeRandomNetlist(argv[2], options.shape) ? 0 : 1;
+    }
+
     Circuit circuit;
     std::string filepathEthernet = "C:/Users/Paul/RiderProjects/Fault_Simulation/Fault_Simulation/Benches/ethernet_synth_NEW.v";
     std::string filepathC17 = "C:/Users/Paul/RiderProjects/Fault_Simulation/Fault_Simulation/Benches/C17_orig.v";
@@ -13,7 +39,10 @@ int main(int argc, char* argv[])
     //circuit.runAndPrintGoodSimulation();
     //circuit.runBigFaultedSimulation();
 
-    circuit.loadFromFile(filepathC17_better);
+    // A netlist given on the command line replaces the default bench.
+    circuit.loadFromFile(argc > 1 ? argv[1] : filepathC17_better);
+    circuit.setPatternParallel(true);
+    circuit.setFaultEngine(FaultSimulator::EVENT_DRIVEN);
     circuit.runAndPrintGoodSimulation();
     circuit.runFaultedSimulation();
     
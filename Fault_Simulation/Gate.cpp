@@ -1,5 +1,7 @@
 ﻿#include "Gate.h"
 
+const unsigned Gate::NumOpcodes;
+
 // Constructor for the Gate class.
 // Initializes a gate with specified type, inputs, outputs, and negation properties.
 Gate::Gate(GateType type, Wire* input1, Wire* input2, Wire* output, bool negInput1, bool negInput2)
@@ -8,7 +10,8 @@ Gate::Gate(GateType type, Wire* input1, Wire* input2, Wire* output, bool negInpu
       input2(input2), // The second input wire to the gate (if applicable).
       output(output), // The output wire of the gate.
       negInput1(negInput1), // Indicates if the first input is logically negated before being used.
-      negInput2(negInput2) // Indicates if the second input is logically negated before being used.
+      negInput2(negInput2), // Indicates if the second input is logically negated before being used.
+      level(0) // The circuit assigns the actual level when it levelizes the netlist.
 {
     
 }
@@ -17,6 +20,12 @@ Gate::~Gate() {
     
 }
 
+// Returns the kernel selector of the gate, see getOpcode in Gate.h.
+unsigned Gate::getOpcode() const {
+    const bool singleInput = type == NOT || type == BUFFER;
+    return 4 * type + (input1 && negInput1 ? 2 : 0) + (input2 && negInput2 && !singleInput ? 1 : 0);
+}
+
 // Computes and sets the output value of the gate based on its inputs and type.
 void Gate::computeOutput() {
     // Calculate the effective value of the first input, applying negation if specified.
@@ -11,6 +11,16 @@ public:
     Wire* getInput1() const { return input1; }
     Wire* getInput2() const { return input2; }
     Wire* getOutput() const { return output; }
+    GateType getType() const { return type; }
+    bool getNegInput1() const { return negInput1; }
+    bool getNegInput2() const { return negInput2; }
+    // Logic level: 0 for gates fed only by primary inputs, otherwise one more than the deepest driving gate.
+    int getLevel() const { return level; }
+    void setLevel(int newLevel) { level = newLevel; }
+    // Selector of the batched gate kernel (see PatternKernels): 4 * type + 2 * negInput1 + negInput2, counting only
+    // the negations the gate applies, since a missing input reads 0 and NOT and BUFFER never read input2.
+    unsigned getOpcode() const;
+    static const unsigned NumOpcodes = 16;
 
 private:
     GateType type;
@@ -19,4 +29,5 @@ private:
     Wire* output;
     bool negInput1;
     bool negInput2;
+    int level;
 };
\ No newline at end of file
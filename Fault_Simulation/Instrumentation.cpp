@@ -0,0 +1,184 @@
+#include "Instrumentation.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+std::atomic<bool> Instrumentation::enabled(false);
+std::atomic<uint64_t> Instrumentation::counters[Instrumentation::NumCounters];
+
+namespace {
+
+const char* const counterNames[Instrumentation::NumCounters] = {
+    "gate_evaluations", "events", "patterns", "faults_dropped", "bytes_written"
+};
+
+// A node of the phase tree: the phase's name below its parent phase (-1 for the top level) and its totals.
+struct PhaseNode {
+    std::string name;
+    int parent;
+    int64_t nanoseconds;
+    uint64_t calls;
+};
+
+std::mutex phaseMutex;
+std::vector<PhaseNode> phaseNodes;
+std::string reportFile;
+// Innermost phase open on this thread, or -1.
+thread_local int currentPhase = -1;
+
+int64_t nowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void writePhases(std::ostream& out, int parent) {
+    out << "[";
+    bool first = true;
+    for (size_t i = 0; i < phaseNodes.size(); ++i) {
+        const PhaseNode& node = phaseNodes[i];
+        if (node.parent != parent) {
+            continue;
+        }
+        out << (first ? "" : ",") << "{\"name\":\"" << node.name << "\",\"seconds\":" << node.nanoseconds * 1e-9
+            << ",\"calls\":" << node.calls << ",\"phases\":";
+        writePhases(out, static_cast<int>(i));
+        out << "}";
+        first = false;
+    }
+    out << "]";
+}
+
+}
+
+// Enables the instrumentation and appends a JSON report line to 'path' at the end of every run; an empty path
+// disables it again.
+void Instrumentation::setReportFile(const std::string& path) {
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    reportFile = path;
+    enabled.store(!path.empty(), std::memory_order_relaxed);
+}
+
+// Peak resident set size of the process so far.
+uint64_t Instrumentation::getPeakResidentBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory))) {
+        return memory.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+Instrumentation::Phase::Phase(const char* name)
+    : node(-1),
+      parent(-1),
+      startNanoseconds(0)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    parent = currentPhase;
+    {
+        std::lock_guard<std::mutex> lock(phaseMutex);
+        for (size_t i = 0; i < phaseNodes.size() && node < 0; ++i) {
+            if (phaseNodes[i].parent == parent && phaseNodes[i].name == name) {
+                node = static_cast<int>(i);
+            }
+        }
+        if (node < 0) {
+            node = static_cast<int>(phaseNodes.size());
+            phaseNodes.push_back(PhaseNode{ name, parent, 0, 0 });
+        }
+    }
+    currentPhase = node;
+    startNanoseconds = nowNanoseconds();
+}
+
+Instrumentation::Phase::~Phase() {
+    finish();
+}
+
+// Books the phase's time; later calls do nothing.
+void Instrumentation::Phase::finish() {
+    if (node < 0) {
+        return;
+    }
+    const int64_t elapsed = nowNanoseconds() - startNanoseconds;
+    {
+        std::lock_guard<std::mutex> lock(phaseMutex);
+        if (static_cast<size_t>(node) < phaseNodes.size()) {
+            phaseNodes[node].nanoseconds += elapsed;
+            ++phaseNodes[node].calls;
+        }
+    }
+    currentPhase = parent;
+    node = -1;
+}
+
+Instrumentation::Run::Run(const char* name)
+    : outermost(startRun()),
+      name(name),
+      phase(name)
+{
+
+}
+
+Instrumentation::Run::~Run() {
+    phase.finish();
+    if (outermost) {
+        writeReport(name);
+    }
+}
+
+// Clears the phases and counters when a run starts outside of any phase. Returns whether it did.
+bool Instrumentation::startRun() {
+    if (!isEnabled() || currentPhase >= 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    phaseNodes.clear();
+    for (std::atomic<uint64_t>& counter : counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// Appends the run's report: its name, the peak RSS, the counters and the phase tree.
+void Instrumentation::writeReport(const char* runName) {
+    std::ostringstream out;
+    out << "{\"run\":\"" << runName << "\",\"peak_rss_bytes\":" << getPeakResidentBytes() << ",\"counters\":{";
+    for (int i = 0; i < NumCounters; ++i) {
+        out << (i ? "," : "") << "\"" << counterNames[i] << "\":" << counters[i].load(std::memory_order_relaxed);
+    }
+    out << "},\"phases\":";
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    writePhases(out, -1);
+    out << "}\n";
+
+    std::ofstream file(reportFile, std::ios::app);
+    if (!file) {
+        std::cerr << "Fehler beim Schreiben des Laufberichts: " << reportFile << std::endl;
+        return;
+    }
+    file << out.str();
+}
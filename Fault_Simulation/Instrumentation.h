@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Built-in performance instrumentation: hierarchical phase timers, throughput counters and the peak resident set
+// size, reported as one JSON object per run (one line each, appended to the report file).
+// Instrumentation is off until a report file is set. The macros below are what the code uses: a phase times the
+// enclosing scope and nests under the phase open on the same thread, a run is a phase that resets the data when
+// it is the outermost one and writes the report when it ends, and counters are added once per call of a hot
+// function (its local count) rather than per gate. Built with FAULT_SIM_INSTRUMENTATION=0 they compile to nothing.
+#ifndef FAULT_SIM_INSTRUMENTATION
+#define FAULT_SIM_INSTRUMENTATION 1
+#endif
+
+class Instrumentation {
+public:
+    enum Counter { GATE_EVALUATIONS, EVENTS, PATTERNS, FAULTS_DROPPED, BYTES_WRITTEN, NumCounters };
+
+    static void setReportFile(const std::string& path);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static void add(Counter counter, uint64_t amount) {
+        if (isEnabled()) {
+            counters[counter].fetch_add(amount, std::memory_order_relaxed);
+        }
+    }
+    static uint64_t getPeakResidentBytes();
+
+    // Times its scope as a phase below the phase open on the constructing thread.
+    class Phase {
+    public:
+        explicit Phase(const char* name);
+        ~Phase();
+
+        void finish();
+
+    private:
+        Phase(const Phase&);
+        Phase& operator=(const Phase&);
+
+        int node;
+        int parent;
+        int64_t startNanoseconds;
+    };
+
+    // The outermost run on a thread starts from cleared phases and counters and writes the report when it ends.
+    class Run {
+    public:
+        explicit Run(const char* name);
+        ~Run();
+
+    private:
+        Run(const Run&);
+        Run& operator=(const Run&);
+
+        bool outermost;
+        const char* name;
+        Phase phase;
+    };
+
+private:
+    static bool startRun();
+    static void writeReport(const char* runName);
+
+    static std::atomic<bool> enabled;
+    static std::atomic<uint64_t> counters[NumCounters];
+};
+
+#if FAULT_SIM_INSTRUMENTATION
+#define INSTRUMENT_CONCAT_(a, b) a##b
+#define INSTRUMENT_CONCAT(a, b) INSTRUMENT_CONCAT_(a, b)
+#define INSTRUMENT_PHASE(name) Instrumentation::Phase INSTRUMENT_CONCAT(instrumentPhase, __LINE__)(name)
+#define INSTRUMENT_RUN(name) Instrumentation::Run INSTRUMENT_CONCAT(instrumentRun, __LINE__)(name)
+#define INSTRUMENT_COUNT(counter, amount) Instrumentation::add(Instrumentation::counter, amount)
+#else
+#define INSTRUMENT_PHASE(name) ((void)0)
+#define INSTRUMENT_RUN(name) ((void)0)
+#define INSTRUMENT_COUNT(counter, amount) ((void)(amount))
+#endif
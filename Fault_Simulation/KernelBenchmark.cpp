@@ -0,0 +1,133 @@
+#include "KernelBenchmark.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "PatternKernels.h"
+
+namespace {
+
+// One gate of the synthetic benchmark netlist, referring to wires by index into a flat value array.
+struct BenchGate {
+    Gate::GateType type;
+    bool negInput1;
+    bool negInput2;
+    size_t input1;
+    size_t input2;
+    size_t output;
+};
+
+typedef void (*GateKernel)(Gate::GateType type, bool negInput1, bool negInput2,
+                           const uint64_t* input1, const uint64_t* input2, uint64_t* output);
+
+// Runs whole passes of one kernel over the netlist, on 'wireWords' words per wire, until the measurement is long
+// enough to be stable, and returns gate evaluations per second. 'checksum' receives the last output word.
+double measureKernel(const std::vector<BenchGate>& gates, size_t numInputs, size_t wireWords, GateKernel kernel,
+                     std::mt19937_64& rng, uint64_t& checksum) {
+    const double minSeconds = 0.5;
+    std::vector<uint64_t> values((numInputs + gates.size()) * wireWords);
+    for (size_t i = 0; i < numInputs * wireWords; ++i) {
+        values[i] = rng();
+    }
+    size_t passes = 0;
+    double seconds = 0.0;
+    const auto start = std::chrono::steady_clock::now();
+    while (seconds < minSeconds) {
+        for (const BenchGate& gate : gates) {
+            kernel(gate.type, gate.negInput1, gate.negInput2, &values[gate.input1 * wireWords],
+                   &values[gate.input2 * wireWords], &values[gate.output * wireWords]);
+        }
+        ++passes;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    checksum = values.back();
+    return static_cast<double>(passes) * gates.size() / seconds;
+}
+
+// The same measurement for the run kernels: the gates are grouped by opcode as the levelization groups a level,
+// and each pass makes one kernel call per opcode. The grouping ignores the dependencies between the gates, which
+// changes the checksum but not the work done.
+double measureRunKernels(const std::vector<BenchGate>& gates, size_t numInputs, size_t wireWords,
+                         const GateRunKernel* kernels, std::mt19937_64& rng, uint64_t& checksum) {
+    const double minSeconds = 0.5;
+    std::vector<uint32_t> input1[Gate::NumOpcodes];
+    std::vector<uint32_t> input2[Gate::NumOpcodes];
+    std::vector<uint32_t> output[Gate::NumOpcodes];
+    for (const BenchGate& gate : gates) {
+        const bool singleInput = gate.type == Gate::NOT || gate.type == Gate::BUFFER;
+        const unsigned opcode = 4 * gate.type + (gate.negInput1 ? 2 : 0) + (gate.negInput2 && !singleInput ? 1 : 0);
+        input1[opcode].push_back(static_cast<uint32_t>(gate.input1));
+        input2[opcode].push_back(static_cast<uint32_t>(gate.input2));
+        output[opcode].push_back(static_cast<uint32_t>(gate.output));
+    }
+    std::vector<uint64_t> values((numInputs + gates.size()) * wireWords);
+    for (size_t i = 0; i < numInputs * wireWords; ++i) {
+        values[i] = rng();
+    }
+    size_t passes = 0;
+    double seconds = 0.0;
+    const auto start = std::chrono::steady_clock::now();
+    while (seconds < minSeconds) {
+        for (unsigned opcode = 0; opcode < Gate::NumOpcodes; ++opcode) {
+            kernels[opcode](input1[opcode].data(), input2[opcode].data(), output[opcode].data(),
+                            output[opcode].size(), values.data());
+        }
+        ++passes;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    checksum = values.back();
+    return static_cast<double>(passes) * gates.size() / seconds;
+}
+
+}
+
+// Measures the throughput of every pattern kernel set the host supports on a synthetic random netlist
+// and prints gate evaluations per second (one gate over one pattern block) and gate-pattern evaluations per second.
+void runKernelBenchmark() {
+    const size_t numInputs = 64;
+    const size_t numGates = 1 << 16;
+
+    // Build a random levelized netlist once; gate i drives wire numInputs + i and reads only earlier wires.
+    std::mt19937_64 rng(42);
+    std::vector<BenchGate> gates(numGates);
+    for (size_t i = 0; i < numGates; ++i) {
+        const size_t available = numInputs + i;
+        // Mostly read recently computed wires, like synthesized netlists do, with some long-range connections.
+        const size_t window = available < 256 ? available : 256;
+        gates[i].type = static_cast<Gate::GateType>(rng() % 4);
+        gates[i].negInput1 = rng() % 2 != 0;
+        gates[i].negInput2 = rng() % 2 != 0;
+        gates[i].input1 = available - 1 - rng() % window;
+        gates[i].input2 = rng() % available;
+        gates[i].output = available;
+    }
+
+    const PatternKernels::IsaLevel levels[] = { PatternKernels::SCALAR, PatternKernels::AVX2, PatternKernels::AVX512 };
+    const char* levelNames[] = { "scalar-u64", "avx2", "avx512" };
+    for (PatternKernels::IsaLevel isa : levels) {
+        const PatternKernels& kernels = getPatternKernels(isa);
+        if (!isIsaSupported(isa) || kernels.isa != isa) {
+            std::cout << levelNames[isa] << ": not supported on this host, skipped.\n";
+            continue;
+        }
+        const size_t words = kernels.blockWords;
+        uint64_t checksum;
+        const double gateEvalsPerSecond = measureKernel(gates, numInputs, words, kernels.evaluateGate, rng, checksum);
+        std::cout << kernels.name << ": " << 64 * words << " patterns per pass, "
+                  << gateEvalsPerSecond / 1e6 << " M gate-evals/s, "
+                  << gateEvalsPerSecond * 64 * words / 1e9 << " G gate-pattern-evals/s"
+                  << " (checksum " << checksum << ")\n";
+
+        // The three-valued kernel works on two rails per wire, so it has twice the words to move.
+        const double dualRailPerSecond = measureKernel(gates, numInputs, 2 * words, kernels.evaluateGateDualRail,
+                                                       rng, checksum);
+        std::cout << kernels.name << " dual-rail 0/1/X: " << dualRailPerSecond / 1e6 << " M gate-evals/s, "
+                  << gateEvalsPerSecond / dualRailPerSecond << "x the two-valued time"
+                  << " (checksum " << checksum << ")\n";
+
+        const double runsPerSecond = measureRunKernels(gates, numInputs, words, kernels.evaluateGateRun, rng, checksum);
+        std::cout << kernels.name << " run kernels: " << runsPerSecond / 1e6 << " M gate-evals/s, "
+                  << runsPerSecond / gateEvalsPerSecond << "x the per-gate rate"
+                  << " (checksum " << checksum << ")\n";
+    }
+}
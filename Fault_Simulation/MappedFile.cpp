@@ -0,0 +1,180 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile()
+    : contents(nullptr), length(0), writable(false), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+{
+
+}
+
+// Maps the file; returns false if it cannot be opened or mapped.
+bool MappedFile::open(const std::string& filepath) {
+    close();
+    fileHandle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    if (length == 0) {
+        // Empty files cannot be mapped, but they are valid (empty) contents.
+        return true;
+    }
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        close();
+        return false;
+    }
+    contents = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!contents) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+// Creates (or truncates) the file with the given size and maps it for writing; returns false on failure.
+bool MappedFile::create(const std::string& filepath, size_t size) {
+    close();
+    fileHandle = CreateFileA(filepath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    length = size;
+    writable = true;
+    if (length == 0) {
+        return true;
+    }
+    // Mapping a size beyond the end of the file extends the file.
+    const unsigned long long mappingSize = size;
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READWRITE, static_cast<DWORD>(mappingSize >> 32),
+                                       static_cast<DWORD>(mappingSize & 0xFFFFFFFFull), nullptr);
+    if (!mappingHandle) {
+        close();
+        return false;
+    }
+    contents = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_WRITE, 0, 0, 0));
+    if (!contents) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (contents) {
+        UnmapViewOfFile(contents);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(fileHandle);
+    }
+    contents = nullptr;
+    length = 0;
+    writable = false;
+    mappingHandle = nullptr;
+    fileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MappedFile::MappedFile()
+    : contents(nullptr), length(0), writable(false), fileDescriptor(-1)
+{
+
+}
+
+// Maps the file; returns false if it cannot be opened or mapped.
+bool MappedFile::open(const std::string& filepath) {
+    close();
+    fileDescriptor = ::open(filepath.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(fileDescriptor, &status) != 0) {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(status.st_size);
+    if (length == 0) {
+        // Empty files cannot be mapped, but they are valid (empty) contents.
+        return true;
+    }
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+    madvise(mapping, length, MADV_SEQUENTIAL);
+    contents = static_cast<const char*>(mapping);
+    return true;
+}
+
+// Creates (or truncates) the file with the given size and maps it for writing; returns false on failure.
+bool MappedFile::create(const std::string& filepath, size_t size) {
+    close();
+    fileDescriptor = ::open(filepath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    length = size;
+    writable = true;
+    if (length == 0) {
+        return true;
+    }
+    if (ftruncate(fileDescriptor, static_cast<off_t>(size)) != 0) {
+        close();
+        return false;
+    }
+    void* mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+    contents = static_cast<const char*>(mapping);
+    return true;
+}
+
+void MappedFile::close() {
+    if (contents) {
+        munmap(const_cast<char*>(contents), length);
+    }
+    if (fileDescriptor >= 0) {
+        ::close(fileDescriptor);
+    }
+    contents = nullptr;
+    length = 0;
+    writable = false;
+    fileDescriptor = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// A memory mapping of a whole file (CreateFileMapping on Windows, mmap elsewhere), either read-only
+// (open) or a new file of a given size that is written through the mapping (create).
+// The contents stay valid until close() or destruction; an empty file maps to size() == 0.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string& filepath);
+    bool create(const std::string& filepath, size_t size);
+    void close();
+
+    const char* data() const { return contents; }
+    // Writable view of a mapping made with create().
+    char* writableData() { return writable ? const_cast<char*>(contents) : nullptr; }
+    size_t size() const { return length; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* contents;
+    size_t length;
+    bool writable;
+#if defined(_WIN32)
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+};
@@ -0,0 +1,390 @@
+#include "NetlistCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+#include "Circuit.h"
+#include "MappedFile.h"
+
+namespace {
+
+const char CacheMagic[8] = { 'F', 'S', 'N', 'E', 'T', 'C', 'A', 'C' };
+// Raised whenever the layout or the gate order of the cache changes; version 2 orders each level by opcode and
+// version 3 adds the payload hash.
+const uint32_t CacheVersion = 3;
+const uint32_t NoWire = 0xFFFFFFFFu;
+
+// Fixed-size file header; every array after it starts on an 8-byte boundary.
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    // Hash of everything behind the header, so a damaged cache is rejected even if its ids are still in range.
+    uint64_t payloadHash;
+    uint64_t numInputs;
+    uint64_t numOutputs;
+    uint64_t numInternalWires;
+    uint64_t numGates;
+    uint64_t numLevels;
+    uint64_t nameBytes;
+    uint64_t fanoutEntries;
+};
+
+// Appends arrays to an in-memory image of the cache file.
+class CacheWriter {
+public:
+    template <typename T>
+    void write(const T* data, size_t count) {
+        const char* bytes = reinterpret_cast<const char*>(data);
+        image.insert(image.end(), bytes, bytes + count * sizeof(T));
+        image.resize((image.size() + 7) & ~size_t(7), 0);
+    }
+
+    template <typename T>
+    void write(const std::vector<T>& data) {
+        write(data.data(), data.size());
+    }
+
+    std::vector<char> image;
+};
+
+// Reads the arrays back from the mapped cache file, failing instead of reading past its end.
+class CacheReader {
+public:
+    CacheReader(const char* data, size_t size) : cursor(data), end(data + size) {}
+
+    template <typename T>
+    const T* read(size_t count) {
+        const size_t bytes = count * sizeof(T);
+        if (static_cast<size_t>(end - cursor) < bytes) {
+            return nullptr;
+        }
+        const T* data = reinterpret_cast<const T*>(cursor);
+        cursor += (bytes + 7) & ~size_t(7);
+        if (cursor > end) {
+            cursor = end;
+        }
+        return data;
+    }
+
+    template <typename T>
+    bool read(std::vector<T>& data, size_t count) {
+        const T* source = read<T>(count);
+        if (!source) {
+            return false;
+        }
+        data.assign(source, source + count);
+        return true;
+    }
+
+private:
+    const char* cursor;
+    const char* end;
+};
+
+// Whether every id is below 'limit'.
+bool allBelow(const uint32_t* ids, size_t count, size_t limit) {
+    for (size_t i = 0; i < count; ++i) {
+        if (ids[i] >= limit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether every value is below 'limit' or equal to 'none'.
+bool allBelowOr(const uint32_t* ids, size_t count, size_t limit, uint32_t none) {
+    for (size_t i = 0; i < count; ++i) {
+        if (ids[i] >= limit && ids[i] != none) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether the offsets never decrease and start at 0, so each one is at most the last.
+template <typename T>
+bool isOffsetTable(const T* offsets, size_t count) {
+    if (count == 0 || offsets[0] != 0) {
+        return false;
+    }
+    for (size_t i = 1; i < count; ++i) {
+        if (offsets[i] < offsets[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Marks 'ids' (all below seen.size()) in 'seen'; false if one of them was already marked.
+bool markOnce(const uint32_t* ids, size_t count, std::vector<uint8_t>& seen) {
+    for (size_t i = 0; i < count; ++i) {
+        if (seen[ids[i]]) {
+            return false;
+        }
+        seen[ids[i]] = 1;
+    }
+    return true;
+}
+
+}
+
+// 64-bit FNV-1a over the text, folded in 8-byte words (the tail byte by byte) to keep up with the mapping.
+uint64_t NetlistCache::hashContents(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 1099511628211ULL;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+    }
+    return hash ^ size;
+}
+
+std::string NetlistCache::getCachePath(const std::string& netlistPath) {
+    return netlistPath + ".fsc";
+}
+
+// Fills an empty circuit from the cache. Returns false, leaving the circuit untouched, if the cache is missing,
+// malformed or was built from different netlist text.
+bool NetlistCache::load(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, Circuit& circuit) {
+    MappedFile file;
+    if (!file.open(cachePath) || file.size() < sizeof(CacheHeader)) {
+        return false;
+    }
+    CacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) != 0 || header.version != CacheVersion ||
+        header.headerSize != sizeof(CacheHeader) || header.sourceHash != sourceHash ||
+        header.sourceSize != sourceSize ||
+        header.payloadHash != hashContents(file.data() + sizeof(CacheHeader), file.size() - sizeof(CacheHeader))) {
+        return false;
+    }
+
+    const size_t numWires = header.numInputs + header.numOutputs + header.numInternalWires;
+    const size_t numGates = header.numGates;
+    if (numWires > file.size() || numGates > file.size() || header.nameBytes > file.size() ||
+        header.fanoutEntries > file.size()) {
+        return false;
+    }
+    CacheReader reader(file.data() + sizeof(CacheHeader), file.size() - sizeof(CacheHeader));
+    const uint32_t* inputWires = reader.read<uint32_t>(header.numInputs);
+    const uint32_t* outputWires = reader.read<uint32_t>(header.numOutputs);
+    const uint32_t* internalWires = reader.read<uint32_t>(header.numInternalWires);
+    const uint64_t* nameOffsets = reader.read<uint64_t>(numWires + 1);
+    const char* names = reader.read<char>(header.nameBytes);
+    const uint8_t* recordType = reader.read<uint8_t>(numGates);
+    const uint8_t* recordNeg1 = reader.read<uint8_t>(numGates);
+    const uint8_t* recordNeg2 = reader.read<uint8_t>(numGates);
+    const uint32_t* recordInput1 = reader.read<uint32_t>(numGates);
+    const uint32_t* recordInput2 = reader.read<uint32_t>(numGates);
+    const uint32_t* recordOutput = reader.read<uint32_t>(numGates);
+    const uint32_t* recordPosition = reader.read<uint32_t>(numGates);
+    if (!inputWires || !outputWires || !internalWires || !nameOffsets || (!names && header.nameBytes) ||
+        (numGates && (!recordType || !recordNeg1 || !recordNeg2 || !recordInput1 || !recordInput2 ||
+                      !recordOutput || !recordPosition))) {
+        return false;
+    }
+
+    CompiledNetlist& compiled = circuit.compiledNetlist;
+    const size_t compiledWires = numWires + 2;
+    bool valid = reader.read(compiled.gateType, numGates) && reader.read(compiled.negInput1, numGates) &&
+                 reader.read(compiled.negInput2, numGates) && reader.read(compiled.gateInput1, numGates) &&
+                 reader.read(compiled.gateInput2, numGates) && reader.read(compiled.gateOutput, numGates) &&
+                 reader.read(compiled.gateLevel, numGates) && reader.read(compiled.driverGate, compiledWires) &&
+                 reader.read(compiled.fanoutStart, compiledWires + 1) &&
+                 reader.read(compiled.fanoutGates, header.fanoutEntries) && reader.read(compiled.isOutput, compiledWires);
+    if (!valid || !isOffsetTable(nameOffsets, numWires + 1) || nameOffsets[numWires] != header.nameBytes) {
+        return false;
+    }
+
+    // The payload hash does not rule out a collision, so every id and offset is still checked before it is used
+    // as an index. The wire lists must hold every wire exactly once, and the gate positions every position.
+    std::vector<uint8_t> seen(numWires, 0);
+    if (!allBelow(inputWires, header.numInputs, numWires) || !allBelow(outputWires, header.numOutputs, numWires) ||
+        !allBelow(internalWires, header.numInternalWires, numWires) ||
+        !markOnce(inputWires, header.numInputs, seen) || !markOnce(outputWires, header.numOutputs, seen) ||
+        !markOnce(internalWires, header.numInternalWires, seen)) {
+        return false;
+    }
+    seen.assign(numGates, 0);
+    if (!allBelow(recordOutput, numGates, numWires) || !allBelowOr(recordInput1, numGates, numWires, NoWire) ||
+        !allBelowOr(recordInput2, numGates, numWires, NoWire) || !allBelow(recordPosition, numGates, numGates) ||
+        !markOnce(recordPosition, numGates, seen)) {
+        return false;
+    }
+    for (size_t g = 0; g < numGates; ++g) {
+        // The record and the compiled gate at its position must describe the same gate.
+        if (recordType[g] > Gate::BUFFER || compiled.gateOutput[recordPosition[g]] != recordOutput[g]) {
+            return false;
+        }
+    }
+    if (header.numLevels > numGates || !allBelow(compiled.gateInput1.data(), numGates, compiledWires) ||
+        !allBelow(compiled.gateInput2.data(), numGates, compiledWires) ||
+        !allBelow(compiled.gateLevel.data(), numGates, header.numLevels) ||
+        !allBelowOr(compiled.driverGate.data(), compiledWires, numGates, CompiledNetlist::NoGate) ||
+        !isOffsetTable(compiled.fanoutStart.data(), compiledWires + 1) ||
+        compiled.fanoutStart[compiledWires] != header.fanoutEntries ||
+        !allBelow(compiled.fanoutGates.data(), header.fanoutEntries, numGates)) {
+        return false;
+    }
+    for (size_t g = 0; g < numGates; ++g) {
+        // The kernels are selected by type and negation flags, so those must be in range as well.
+        if (compiled.gateType[g] > Gate::BUFFER || compiled.negInput1[g] > 1 || compiled.negInput2[g] > 1) {
+            return false;
+        }
+    }
+
+    // Recreate the wires under their ids, then the gates in parse order with their driver and fanout links.
+    std::vector<Wire*> wiresById(numWires, nullptr);
+    for (size_t w = 0; w < numWires; ++w) {
+        wiresById[w] = new Wire(std::string(names + nameOffsets[w], names + nameOffsets[w + 1]));
+        wiresById[w]->setId(static_cast<uint32_t>(w));
+    }
+    for (size_t i = 0; i < header.numInputs; ++i) {
+        circuit.inputs.push_back(wiresById[inputWires[i]]);
+    }
+    for (size_t i = 0; i < header.numOutputs; ++i) {
+        circuit.outputs.push_back(wiresById[outputWires[i]]);
+    }
+    for (size_t i = 0; i < header.numInternalWires; ++i) {
+        circuit.internalWires.push_back(wiresById[internalWires[i]]);
+    }
+    circuit.levelizedGates.assign(numGates, nullptr);
+    for (size_t g = 0; g < numGates; ++g) {
+        Wire* input1 = recordInput1[g] == NoWire ? nullptr : wiresById[recordInput1[g]];
+        Wire* input2 = recordInput2[g] == NoWire ? nullptr : wiresById[recordInput2[g]];
+        Gate* gate = new Gate(static_cast<Gate::GateType>(recordType[g]), input1, input2, wiresById[recordOutput[g]],
+                              recordNeg1[g] != 0, recordNeg2[g] != 0);
+        gate->setLevel(static_cast<int>(compiled.gateLevel[recordPosition[g]]));
+        circuit.gates.push_back(gate);
+        gate->getOutput()->setDriver(gate);
+        if (input1) {
+            input1->addFanout(gate);
+        }
+        if (input2) {
+            input2->addFanout(gate);
+        }
+        circuit.levelizedGates[recordPosition[g]] = gate;
+    }
+
+    compiled.inputIds.assign(inputWires, inputWires + header.numInputs);
+    compiled.outputIds.assign(outputWires, outputWires + header.numOutputs);
+    compiled.numLevels = static_cast<uint32_t>(header.numLevels);
+    compiled.setCircuitWireCount(numWires);
+    circuit.levelizationValid = true;
+    circuit.compiledOptimization = NetlistOptimizer::NO_OPTIMIZATION;
+    circuit.compiledNetlistValid = true;
+    // The name index is only built if a lookup by name is needed.
+    circuit.wireIndexValid = false;
+    return true;
+}
+
+// Writes the cache for a freshly parsed and compiled circuit. Returns false if the file cannot be written.
+bool NetlistCache::save(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, Circuit& circuit) {
+    circuit.compileNetlist();
+    const CompiledNetlist& compiled = circuit.compiledNetlist;
+    const std::vector<Wire*> allWires = circuit.getAllWires();
+    const std::vector<Gate*>& evaluationOrder = circuit.getLevelizedGates();
+
+    std::vector<Wire*> wiresById(allWires.size(), nullptr);
+    for (Wire* wire : allWires) {
+        wiresById[wire->getId()] = wire;
+    }
+    CacheHeader header = {};
+    std::memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+    header.version = CacheVersion;
+    header.headerSize = sizeof(CacheHeader);
+    header.sourceHash = sourceHash;
+    header.sourceSize = sourceSize;
+    header.numInputs = circuit.inputs.size();
+    header.numOutputs = circuit.outputs.size();
+    header.numInternalWires = circuit.internalWires.size();
+    header.numGates = circuit.gates.size();
+    header.numLevels = compiled.numLevels;
+    header.fanoutEntries = compiled.fanoutGates.size();
+
+    CacheWriter writer;
+    writer.write(&header, 1);
+    std::vector<uint32_t> ids;
+    for (const std::vector<Wire*>* wires : { &circuit.inputs, &circuit.outputs, &circuit.internalWires }) {
+        ids.clear();
+        for (Wire* wire : *wires) {
+            ids.push_back(wire->getId());
+        }
+        writer.write(ids);
+    }
+
+    // Interned names: the name of wire w is names[nameOffsets[w]] .. names[nameOffsets[w + 1] - 1].
+    std::vector<uint64_t> nameOffsets(1, 0);
+    std::string names;
+    for (Wire* wire : wiresById) {
+        names += wire->getName();
+        nameOffsets.push_back(names.size());
+    }
+    writer.write(nameOffsets);
+    writer.write(names.data(), names.size());
+
+    // Gates in parse order with their position in the evaluation order.
+    const size_t numGates = circuit.gates.size();
+    std::unordered_map<const Gate*, uint32_t> positions;
+    for (size_t i = 0; i < evaluationOrder.size(); ++i) {
+        positions[evaluationOrder[i]] = static_cast<uint32_t>(i);
+    }
+    std::vector<uint8_t> recordType(numGates), recordNeg1(numGates), recordNeg2(numGates);
+    std::vector<uint32_t> recordInput1(numGates), recordInput2(numGates), recordOutput(numGates), recordPosition(numGates);
+    for (size_t g = 0; g < numGates; ++g) {
+        const Gate* gate = circuit.gates[g];
+        auto position = positions.find(gate);
+        if (position == positions.end()) {
+            return false; // Gates on a combinational loop are not levelized; such netlists are not cached.
+        }
+        recordType[g] = static_cast<uint8_t>(gate->getType());
+        recordNeg1[g] = gate->getNegInput1();
+        recordNeg2[g] = gate->getNegInput2();
+        recordInput1[g] = gate->getInput1() ? gate->getInput1()->getId() : NoWire;
+        recordInput2[g] = gate->getInput2() ? gate->getInput2()->getId() : NoWire;
+        recordOutput[g] = gate->getOutput()->getId();
+        recordPosition[g] = position->second;
+    }
+    writer.write(recordType);
+    writer.write(recordNeg1);
+    writer.write(recordNeg2);
+    writer.write(recordInput1);
+    writer.write(recordInput2);
+    writer.write(recordOutput);
+    writer.write(recordPosition);
+
+    writer.write(compiled.gateType);
+    writer.write(compiled.negInput1);
+    writer.write(compiled.negInput2);
+    writer.write(compiled.gateInput1);
+    writer.write(compiled.gateInput2);
+    writer.write(compiled.gateOutput);
+    writer.write(compiled.gateLevel);
+    writer.write(compiled.driverGate);
+    writer.write(compiled.fanoutStart);
+    writer.write(compiled.fanoutGates);
+    writer.write(compiled.isOutput);
+
+    header.nameBytes = names.size();
+    header.payloadHash = hashContents(writer.image.data() + sizeof(header), writer.image.size() - sizeof(header));
+    std::memcpy(writer.image.data(), &header, sizeof(header));
+
+    // Write to a temporary file first so that an interrupted run never leaves a truncated cache behind.
+    const std::string temporaryPath = cachePath + ".tmp";
+    {
+        std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!out.write(writer.image.data(), static_cast<std::streamsize>(writer.image.size()))) {
+            return false;
+        }
+    }
+    std::remove(cachePath.c_str());
+    return std::rename(temporaryPath.c_str(), cachePath.c_str()) == 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Circuit;
+
+// Binary precompiled form of a parsed netlist, stored next to the .v file (<netlist>.fsc).
+// The cache holds the circuit's wires with an interned name table, its gates in parse order, and the
+// compiled gate arrays, levels and fanout lists, so a later load maps the file and copies the arrays
+// without tokenizing, resolving names or levelizing. Each cache records a hash of the netlist text it
+// was built from and is ignored (and rewritten) when the text changes, and a hash of its own contents, so a
+// damaged cache is ignored as well.
+class NetlistCache {
+public:
+    static uint64_t hashContents(const char* data, size_t size);
+    static std::string getCachePath(const std::string& netlistPath);
+    static bool load(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, Circuit& circuit);
+    static bool save(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, Circuit& circuit);
+};
@@ -0,0 +1,179 @@
+#include "NetlistGenerator.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "Gate.h"
+
+namespace {
+
+// One generated gate; wires 0 .. numInputs-1 are the primary inputs and gate g drives wire numInputs + g.
+struct GeneratedGate {
+    Gate::GateType type;
+    bool negInput1;
+    bool negInput2;
+    uint32_t input1;
+    uint32_t input2;
+};
+
+const size_t FlushBytes = size_t(1) << 20;
+
+void appendWireName(std::string& out, uint32_t wire, size_t numInputs) {
+    if (wire < numInputs) {
+        out += 'i';
+        out += std::to_string(wire);
+    } else {
+        out += 'n';
+        out += std::to_string(wire - numInputs);
+    }
+}
+
+bool flushTo(std::FILE* file, std::string& out) {
+    const bool written = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    out.clear();
+    return written;
+}
+
+}
+
+bool writeRandomNetlist(const std::string& path, const NetlistShape& shape) {
+    const size_t numInputs = std::max<size_t>(shape.numInputs, 1);
+    const size_t numGates = std::max<size_t>(shape.numGates, 1);
+    const size_t depth = std::min(std::max<size_t>(shape.depth, 1), numGates);
+    const size_t maxFanout = std::max<size_t>(shape.maxFanout, 1);
+    std::mt19937_64 rng(shape.seed);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    std::vector<GeneratedGate> gates(numGates);
+    std::vector<uint32_t> fanout(numInputs + numGates, 0);
+    std::vector<uint32_t> order;
+    // Wires of the layer below that no first pin reads, and primary inputs no earlier layer has read; the second
+    // pins take these before any random wire.
+    std::vector<uint32_t> unread;
+    size_t belowBegin = 0;
+    size_t belowEnd = numInputs;
+    for (size_t layer = 0; layer < depth; ++layer) {
+        const size_t first = layer * numGates / depth;
+        const size_t last = (layer + 1) * numGates / depth;
+        const size_t belowSize = belowEnd - belowBegin;
+        order.resize(belowSize);
+        for (size_t k = 0; k < belowSize; ++k) {
+            order[k] = static_cast<uint32_t>(belowBegin + k);
+        }
+        std::shuffle(order.begin(), order.end(), rng);
+        // The first pins read order[0 .. last - first), wrapping around if the layer below is the smaller one.
+        std::vector<uint32_t> unreadInputs;
+        for (uint32_t wire : unread) {
+            if (wire < numInputs && fanout[wire] == 0) {
+                unreadInputs.push_back(wire);
+            }
+        }
+        unread.assign(order.begin() + std::min(last - first, belowSize), order.end());
+        unread.insert(unread.end(), unreadInputs.begin(), unreadInputs.end());
+
+        for (size_t g = first; g < last; ++g) {
+            GeneratedGate& gate = gates[g];
+            const unsigned kind = static_cast<unsigned>(rng() % 100);
+            gate.type = kind < 8 ? Gate::NOT : kind < 12 ? Gate::BUFFER : kind < 56 ? Gate::AND : Gate::OR;
+            gate.negInput1 = gate.type != Gate::NOT && gate.type != Gate::BUFFER && chance(rng) < 0.4;
+            gate.negInput2 = gate.type != Gate::NOT && gate.type != Gate::BUFFER && chance(rng) < 0.4;
+            gate.input1 = order[(g - first) % belowSize];
+            gate.input2 = gate.input1;
+            ++fanout[gate.input1];
+            if (gate.type == Gate::NOT || gate.type == Gate::BUFFER) {
+                continue;
+            }
+            // An unread wire if one is left, otherwise up to eight tries for a second wire that is below the fanout
+            // limit and not the first pin's wire.
+            const size_t earlierWires = numInputs + first;
+            if (!unread.empty()) {
+                gate.input2 = unread.back();
+                unread.pop_back();
+            } else {
+                for (int attempt = 0; attempt < 8; ++attempt) {
+                    const uint32_t candidate = static_cast<uint32_t>(chance(rng) < shape.locality
+                                                                         ? belowBegin + rng() % belowSize
+                                                                         : rng() % earlierWires);
+                    if (candidate == gate.input1) {
+                        continue;
+                    }
+                    gate.input2 = candidate;
+                    if (fanout[candidate] < maxFanout) {
+                        break;
+                    }
+                }
+            }
+            if (gate.input2 == gate.input1) {
+                gate.input2 = static_cast<uint32_t>(gate.input1 + 1 < earlierWires ? gate.input1 + 1 : 0);
+            }
+            ++fanout[gate.input2];
+        }
+        belowBegin = numInputs + first;
+        belowEnd = numInputs + last;
+    }
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Fehler beim Oeffnen der Netzlistendatei: " << path << std::endl;
+        return false;
+    }
+    bool written = true;
+    std::string out;
+    out.reserve(FlushBytes + 256);
+    out += "// Synthetic benchmark netlist: " + std::to_string(numGates) + " gates in " + std::to_string(depth)
+         + " layers, " + std::to_string(numInputs) + " inputs, fanout limit " + std::to_string(maxFanout)
+         + ", seed " + std::to_string(shape.seed) + "\n";
+    out += "module bench ( );\n";
+    for (uint32_t wire = 0; wire < numInputs; ++wire) {
+        out += "input  ";
+        appendWireName(out, wire, numInputs);
+        out += " ;\n";
+    }
+    for (size_t g = 0; g < numGates; ++g) {
+        const uint32_t wire = static_cast<uint32_t>(numInputs + g);
+        out += fanout[wire] ? "wire   " : "output ";
+        appendWireName(out, wire, numInputs);
+        out += " ;\n";
+        if (out.size() >= FlushBytes) {
+            written = flushTo(file, out) && written;
+        }
+    }
+
+    std::vector<uint32_t> assignOrder(numGates);
+    for (size_t g = 0; g < numGates; ++g) {
+        assignOrder[g] = static_cast<uint32_t>(g);
+    }
+    std::shuffle(assignOrder.begin(), assignOrder.end(), rng);
+    for (uint32_t g : assignOrder) {
+        const GeneratedGate& gate = gates[g];
+        out += "  assign ";
+        appendWireName(out, static_cast<uint32_t>(numInputs + g), numInputs);
+        out += " = ";
+        if (gate.type == Gate::NOT) {
+            out += '~';
+        }
+        if (gate.negInput1) {
+            out += '~';
+        }
+        appendWireName(out, gate.input1, numInputs);
+        if (gate.type == Gate::AND || gate.type == Gate::OR) {
+            out += gate.type == Gate::AND ? " & " : " | ";
+            if (gate.negInput2) {
+                out += '~';
+            }
+            appendWireName(out, gate.input2, numInputs);
+        }
+        out += " ;\n";
+        if (out.size() >= FlushBytes) {
+            written = flushTo(file, out) && written;
+        }
+    }
+    out += "endmodule\n";
+    written = flushTo(file, out) && written;
+    if (std::fclose(file) != 0 || !written) {
+        std::cerr << "Fehler beim Schreiben der Netzlistendatei: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Shape of a synthetic benchmark netlist.
+struct NetlistShape {
+    size_t numInputs = 64;
+    size_t numGates = 1000;
+    // Number of gate layers; a gate reads the layer below it.
+    size_t depth = 32;
+    // A wire is read by more gates only when no other candidate is found.
+    size_t maxFanout = 4;
+    // Share of second gate pins that read the layer below; the others reach any earlier wire.
+    double locality = 0.75;
+    uint64_t seed = 1;
+};
+
+// Writes a random layered netlist in the assign dialect of the benches: 'depth' layers of AND, OR, NOT and buffer
+// gates with random input inversions. The first pin of a layer's gates walks over the layer below in random order,
+// and the second pins first take the wires of the layer below that the walk missed and the primary inputs that no
+// earlier layer read. So every primary input is read unless the gates have fewer pins than there are inputs, and
+// every gate output nobody reads becomes a primary output, so every fault site is observable. The assigns are
+// written in random order, like synthesized netlists. The same shape always gives the same file. Returns false if
+// the file could not be written.
+bool writeRandomNetlist(const std::string& path, const NetlistShape& shape);
@@ -0,0 +1,260 @@
+#include "NetlistOptimizer.h"
+#include <algorithm>
+#include <unordered_map>
+
+const uint32_t NetlistOptimizer::Constant;
+
+namespace {
+
+// An AND/OR gate as the structural hash sees it: its type and its two pins (wire id and negation), pins sorted.
+struct GateKey {
+    uint64_t pin1;
+    uint64_t pin2;
+    uint8_t type;
+
+    bool operator==(const GateKey& other) const {
+        return pin1 == other.pin1 && pin2 == other.pin2 && type == other.type;
+    }
+};
+
+struct GateKeyHash {
+    size_t operator()(const GateKey& key) const {
+        uint64_t hash = key.pin1 * 0x9E3779B97F4A7C15ULL ^ (key.pin2 + key.type) * 0xC2B2AE3D27D4EB4FULL;
+        return static_cast<size_t>(hash ^ (hash >> 29));
+    }
+};
+
+// Whether 'gate' is the only reader of 'wire' (on one or both pins) and the wire is no primary output, so the
+// wire's faults reach the outputs only through the gate.
+bool isOnlyReader(const Wire* wire, const Gate* gate, const std::vector<uint8_t>& isOutput) {
+    if (isOutput[wire->getId()]) {
+        return false;
+    }
+    for (const Gate* reader : wire->getFanout()) {
+        if (reader != gate) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+NetlistOptimizer::NetlistOptimizer()
+    : active(false),
+      removedBuffers(0),
+      removedConstants(0),
+      mergedGates(0),
+      removedDead(0)
+{
+
+}
+
+void NetlistOptimizer::clear() {
+    active = false;
+    wiresById.clear();
+    aliases.clear();
+    wireLevel.clear();
+    ownedGates.clear();
+    evaluationOrder.clear();
+    outputWires.clear();
+    removedBuffers = 0;
+    removedConstants = 0;
+    mergedGates = 0;
+    removedDead = 0;
+}
+
+// Rewrites the gates of 'order' (a topological order of the circuit's gates) in one pass: each gate's pins are read
+// through the aliases of the wires it reads, and the gate is either replaced by an alias for its output or kept.
+void NetlistOptimizer::optimize(const std::vector<Wire*>& allWires, const std::vector<Wire*>& inputs,
+                                const std::vector<Wire*>& outputs, const std::vector<Gate*>& order, Mode mode) {
+    clear();
+    if (mode == NO_OPTIMIZATION) {
+        return;
+    }
+    active = true;
+    const size_t numWires = allWires.size();
+    wiresById.assign(numWires, nullptr);
+    aliases.resize(numWires);
+    wireLevel.assign(numWires, -1);
+    std::vector<uint8_t> isOutput(numWires, 0);
+    for (Wire* wire : allWires) {
+        wiresById[wire->getId()] = wire;
+        aliases[wire->getId()] = Signal{ wire->getId(), false };
+    }
+    for (Wire* wire : outputs) {
+        isOutput[wire->getId()] = 1;
+    }
+    if (mode == FUNCTIONAL) {
+        // A wire that is neither a primary input nor driven by a gate reads 0.
+        std::vector<uint8_t> isInput(numWires, 0);
+        for (Wire* wire : inputs) {
+            isInput[wire->getId()] = 1;
+        }
+        for (Wire* wire : allWires) {
+            if (!wire->getDriver() && !isInput[wire->getId()]) {
+                aliases[wire->getId()] = Signal{ Constant, false };
+            }
+        }
+    }
+    // A gate is dead when its output reaches no primary output; its faults can never be detected, so its output
+    // becomes a constant and the gate is dropped.
+    std::vector<uint8_t> isLive(isOutput);
+    for (size_t g = order.size(); g-- > 0;) {
+        const Wire* output = order[g]->getOutput();
+        for (const Gate* reader : output->getFanout()) {
+            isLive[output->getId()] |= isLive[reader->getOutput()->getId()];
+        }
+    }
+    ownedGates.reserve(order.size() + outputs.size());
+
+    std::unordered_map<GateKey, uint32_t, GateKeyHash> structuralHash;
+    structuralHash.reserve(mode == FUNCTIONAL ? order.size() : 0);
+    for (const Gate* gate : order) {
+        Wire* output = gate->getOutput();
+        if (!isLive[output->getId()]) {
+            aliases[output->getId()] = Signal{ Constant, false };
+            ++removedDead;
+            continue;
+        }
+        const Gate::GateType type = gate->getType();
+        const Signal pin1 = readPin(gate->getInput1(), gate->getNegInput1());
+
+        if (type == Gate::NOT || type == Gate::BUFFER) {
+            Signal result = pin1;
+            result.inverted = result.inverted != (type == Gate::NOT);
+            const bool collapse = mode == FUNCTIONAL ||
+                                  (gate->getInput1() && isOnlyReader(gate->getInput1(), gate, isOutput) &&
+                                   !(isOutput[output->getId()] && result.inverted));
+            if (collapse) {
+                aliases[output->getId()] = result;
+                ++removedBuffers;
+            } else {
+                addGate(type, pin1, Signal{ Constant, false }, output);
+            }
+            continue;
+        }
+
+        const Signal pin2 = readPin(gate->getInput2(), gate->getNegInput2());
+        // The pin value that decides the output on its own: 0 for AND, 1 for OR.
+        const bool controlling = type == Gate::OR;
+        if (mode == EQUIVALENT) {
+            if (gate->getInput1() && gate->getInput1() == gate->getInput2() && pin1.inverted == pin2.inverted &&
+                isOnlyReader(gate->getInput1(), gate, isOutput) && !(isOutput[output->getId()] && pin1.inverted)) {
+                aliases[output->getId()] = pin1;
+                ++mergedGates;
+            } else {
+                addGate(type, pin1, pin2, output);
+            }
+            continue;
+        }
+
+        if (pin1.wire == Constant || pin2.wire == Constant) {
+            const Signal& constant = pin1.wire == Constant ? pin1 : pin2;
+            const Signal& other = pin1.wire == Constant ? pin2 : pin1;
+            aliases[output->getId()] = constant.inverted == controlling ? constant : other;
+            ++removedConstants;
+            continue;
+        }
+        if (pin1.wire == pin2.wire) {
+            if (pin1.inverted == pin2.inverted) {
+                aliases[output->getId()] = pin1;
+                ++mergedGates;
+            } else {
+                aliases[output->getId()] = Signal{ Constant, controlling };
+                ++removedConstants;
+            }
+            continue;
+        }
+        const uint64_t packed1 = uint64_t(pin1.wire) << 1 | (pin1.inverted ? 1 : 0);
+        const uint64_t packed2 = uint64_t(pin2.wire) << 1 | (pin2.inverted ? 1 : 0);
+        const GateKey key = { std::min(packed1, packed2), std::max(packed1, packed2), static_cast<uint8_t>(type) };
+        const auto existing = structuralHash.emplace(key, output->getId());
+        if (!existing.second) {
+            aliases[output->getId()] = Signal{ existing.first->second, false };
+            ++mergedGates;
+            continue;
+        }
+        addGate(type, pin1, pin2, output);
+    }
+
+    // A primary output reads the wire carrying its value; an inverted or constant value gets a gate of its own.
+    for (Wire* output : outputs) {
+        const Signal value = aliases[output->getId()];
+        if (value.wire != Constant && !value.inverted) {
+            outputWires.push_back(wiresById[value.wire]);
+            continue;
+        }
+        if (value.wire == Constant) {
+            addGate(value.inverted ? Gate::NOT : Gate::BUFFER, value, value, output);
+        } else {
+            addGate(Gate::NOT, Signal{ value.wire, false }, Signal{ Constant, false }, output);
+        }
+        aliases[output->getId()] = Signal{ output->getId(), false };
+        outputWires.push_back(output);
+    }
+
+    // Bucket the kept gates by their new levels and opcodes (a stable counting sort) like Circuit::getLevelizedGates.
+    int maxLevel = -1;
+    for (const std::unique_ptr<Gate>& gate : ownedGates) {
+        maxLevel = std::max(maxLevel, gate->getLevel());
+    }
+    const size_t numBuckets = size_t(maxLevel + 1) * Gate::NumOpcodes;
+    std::vector<size_t> bucketStart(numBuckets + 1, 0);
+    for (const std::unique_ptr<Gate>& gate : ownedGates) {
+        ++bucketStart[gate->getLevel() * Gate::NumOpcodes + gate->getOpcode() + 1];
+    }
+    for (size_t bucket = 0; bucket < numBuckets; ++bucket) {
+        bucketStart[bucket + 1] += bucketStart[bucket];
+    }
+    evaluationOrder.assign(ownedGates.size(), nullptr);
+    for (const std::unique_ptr<Gate>& gate : ownedGates) {
+        evaluationOrder[bucketStart[gate->getLevel() * Gate::NumOpcodes + gate->getOpcode()]++] = gate.get();
+    }
+}
+
+// Maps a stem fault onto the wire carrying the faulty wire's value, with the stuck value inverted if the wire is
+// an inverted alias. Returns false for a fault on a constant wire, which after an EQUIVALENT pass is the output of a
+// dead gate that no pattern detects. Branch faults and faults on kept wires are returned unchanged.
+bool NetlistOptimizer::resolveFault(const StuckAtFault& fault, StuckAtFault& simulated) const {
+    simulated = fault;
+    if (!active || fault.isBranch() || fault.wire >= aliases.size()) {
+        return true;
+    }
+    const Signal alias = aliases[fault.wire];
+    if (alias.wire == Constant) {
+        return false;
+    }
+    simulated.wire = alias.wire;
+    simulated.value = fault.value != alias.inverted;
+    return true;
+}
+
+// The signal a gate pin sees: the alias of its wire with the pin's negation applied. A missing input reads 0.
+NetlistOptimizer::Signal NetlistOptimizer::readPin(const Wire* input, bool negated) const {
+    if (!input) {
+        return Signal{ Constant, false };
+    }
+    Signal signal = aliases[input->getId()];
+    signal.inverted = signal.inverted != negated;
+    return signal;
+}
+
+// Adds a kept gate on the given signals. A constant pin becomes a missing input, which reads 0; a constant 1 pin
+// only reaches here as the input of a NOT or BUFFER gate driving a constant output, and is made up by the type.
+void NetlistOptimizer::addGate(Gate::GateType type, Signal input1, Signal input2, Wire* output) {
+    Wire* wire1 = input1.wire == Constant ? nullptr : wiresById[input1.wire];
+    Wire* wire2 = input2.wire == Constant ? nullptr : wiresById[input2.wire];
+    const bool singleInput = type == Gate::NOT || type == Gate::BUFFER;
+    ownedGates.emplace_back(new Gate(type, wire1, singleInput ? nullptr : wire2, output,
+                                     wire1 && input1.inverted, !singleInput && wire2 && input2.inverted));
+    int level = 0;
+    if (wire1) {
+        level = std::max(level, wireLevel[wire1->getId()] + 1);
+    }
+    if (wire2 && !singleInput) {
+        level = std::max(level, wireLevel[wire2->getId()] + 1);
+    }
+    ownedGates.back()->setLevel(level);
+    wireLevel[output->getId()] = level;
+}
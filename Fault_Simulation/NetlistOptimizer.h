@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "FaultSimulator.h"
+#include "Gate.h"
+#include "Wire.h"
+
+// Pre-simulation rewrite of a circuit's gates into a smaller gate list for the compiled netlist. The circuit's own
+// gates and wires stay as they are, so the serial engine and the reports keep the original netlist.
+// Both modes drop dead gates, whose outputs reach no primary output; their wires become constants.
+// EQUIVALENT only removes gates whose output faults are equivalent to the faults of a surviving wire: buffers and
+// inverters (and AND/OR gates reading one wire on both pins) whose input wire feeds nothing else. Their readers read
+// that wire instead, with the negation flag toggled for an inverter, so inverter chains fold away as well.
+// FUNCTIONAL collapses every buffer and inverter, propagates constants (undriven wires are 0, x & ~x is 0 and
+// x | ~x is 1) and merges AND/OR gates computing the same function of the same wires (structural hashing). The
+// outputs stay the same for every two-valued pattern, but a removed wire's faults are in general not equivalent to
+// any fault of the optimized netlist, so FUNCTIONAL is only used for good simulation; Circuit::compileNetlist
+// compiles the EQUIVALENT form for the runs that grade faults.
+// Every removed wire keeps an alias, the surviving wire carrying its value (possibly inverted) or a constant. After
+// a NO_OPTIMIZATION or EQUIVALENT pass, resolveFault maps a fault on it onto the equivalent fault of the optimized
+// netlist.
+class NetlistOptimizer {
+public:
+    enum Mode { NO_OPTIMIZATION, EQUIVALENT, FUNCTIONAL };
+
+    NetlistOptimizer();
+
+    void optimize(const std::vector<Wire*>& allWires, const std::vector<Wire*>& inputs,
+                  const std::vector<Wire*>& outputs, const std::vector<Gate*>& evaluationOrder, Mode mode);
+    void clear();
+
+    bool isActive() const { return active; }
+    // The gates to compile, levelized, and the wire carrying each primary output's value.
+    const std::vector<Gate*>& getGates() const { return evaluationOrder; }
+    const std::vector<Wire*>& getOutputs() const { return outputWires; }
+    bool resolveFault(const StuckAtFault& fault, StuckAtFault& simulated) const;
+
+    size_t getRemovedBuffers() const { return removedBuffers; }
+    size_t getRemovedConstants() const { return removedConstants; }
+    size_t getMergedGates() const { return mergedGates; }
+    size_t getRemovedDead() const { return removedDead; }
+
+private:
+    static const uint32_t Constant = 0xFFFFFFFFu;
+
+    // The signal of a wire in the optimized netlist: wire 'wire' inverted if 'inverted', or the constant
+    // 'inverted' if 'wire' is Constant.
+    struct Signal {
+        uint32_t wire;
+        bool inverted;
+    };
+
+    NetlistOptimizer(const NetlistOptimizer&);
+    NetlistOptimizer& operator=(const NetlistOptimizer&);
+
+    Signal readPin(const Wire* input, bool negated) const;
+    void addGate(Gate::GateType type, Signal input1, Signal input2, Wire* output);
+
+    bool active;
+    std::vector<Wire*> wiresById;
+    std::vector<Signal> aliases;
+    std::vector<int> wireLevel;
+    std::vector<std::unique_ptr<Gate>> ownedGates;
+    std::vector<Gate*> evaluationOrder;
+    std::vector<Wire*> outputWires;
+    size_t removedBuffers;
+    size_t removedConstants;
+    size_t mergedGates;
+    size_t removedDead;
+};
@@ -0,0 +1,130 @@
+#include "ParallelFaultSimulator.h"
+#include "Instrumentation.h"
+
+const size_t ParallelFaultSimulator::FaultsPerPass;
+
+ParallelFaultSimulator::ParallelFaultSimulator(const CompiledNetlist& netlist)
+    : netlist(netlist),
+      values(netlist.getNumWires(), 0),
+      forceMask(netlist.getNumWires(), 0),
+      forceBits(netlist.getNumWires(), 0),
+      pinMask(2 * netlist.getNumGates(), 0),
+      pinBits(2 * netlist.getNumGates(), 0)
+{
+
+}
+
+// Injects up to FaultsPerPass faults, fault i into lane i + 1, replacing the faults of the previous group.
+void ParallelFaultSimulator::loadFaults(const StuckAtFault* faults, size_t count) {
+    for (uint32_t wire : forcedWires) {
+        forceMask[wire] = 0;
+        forceBits[wire] = 0;
+        // No gate rewrites an undriven wire, so its stuck lanes are cleared here; inputs are reloaded per pattern.
+        if (netlist.driverGate[wire] == CompiledNetlist::NoGate) {
+            values[wire] = 0;
+        }
+    }
+    forcedWires.clear();
+    for (uint32_t pin : forcedPins) {
+        pinMask[pin] = 0;
+        pinBits[pin] = 0;
+    }
+    forcedPins.clear();
+    for (size_t i = 0; i < count && i < FaultsPerPass; ++i) {
+        const uint64_t lane = uint64_t(1) << (i + 1);
+        if (faults[i].isBranch()) {
+            // Branch faults force the lane only where their gate reads the pin, see evaluateGates.
+            const uint32_t pin = 2 * faults[i].gate + faults[i].pin;
+            if (!pinMask[pin]) {
+                forcedPins.push_back(pin);
+            }
+            pinMask[pin] |= lane;
+            pinBits[pin] = faults[i].value ? (pinBits[pin] | lane) : (pinBits[pin] & ~lane);
+            continue;
+        }
+        const uint32_t wire = faults[i].wire;
+        if (!forceMask[wire]) {
+            forcedWires.push_back(wire);
+        }
+        forceMask[wire] |= lane;
+        forceBits[wire] = faults[i].value ? (forceBits[wire] | lane) : (forceBits[wire] & ~lane);
+    }
+}
+
+// Evaluates all gates in level order over the 64 machines, one gate run of the compiled netlist at a time. The
+// pin masks are only applied when branch faults are loaded, so stem-only groups run the same loop as before.
+template <bool BranchFaults>
+void ParallelFaultSimulator::evaluateGates() {
+    typedef void (ParallelFaultSimulator::*RunEvaluator)(size_t, size_t);
+    static const RunEvaluator evaluators[Gate::NumOpcodes] = {
+        &ParallelFaultSimulator::evaluateRun<BranchFaults, 0>, &ParallelFaultSimulator::evaluateRun<BranchFaults, 1>,
+        &ParallelFaultSimulator::evaluateRun<BranchFaults, 2>, &ParallelFaultSimulator::evaluateRun<BranchFaults, 3>,
+        &ParallelFaultSimulator::evaluateRun<BranchFaults, 4>, &ParallelFaultSimulator::evaluateRun<BranchFaults, 5>,
+        &ParallelFaultSimulator::evaluateRun<BranchFaults, 6>, &ParallelFaultSimulator::evaluateRun<BranchFaults, 7>,
+        &ParallelFaultSimulator::evaluateRun<BranchFaults, 8>, &ParallelFaultSimulator::evaluateRun<BranchFaults, 9>,
+        &ParallelFaultSimulator::evaluateRun<BranchFaults, 10>, &ParallelFaultSimulator::evaluateRun<BranchFaults, 11>,
+        &ParallelFaultSimulator::evaluateRun<BranchFaults, 12>, &ParallelFaultSimulator::evaluateRun<BranchFaults, 13>,
+        &ParallelFaultSimulator::evaluateRun<BranchFaults, 14>, &ParallelFaultSimulator::evaluateRun<BranchFaults, 15>
+    };
+    for (size_t r = 0; r < netlist.gateRunOpcode.size(); ++r) {
+        (this->*evaluators[netlist.gateRunOpcode[r]])(netlist.gateRunStart[r], netlist.gateRunStart[r + 1]);
+    }
+}
+
+// Evaluates the gates first .. end-1, which share the opcode (see Gate::getOpcode), with the gate type and the
+// negations fixed at compile time.
+template <bool BranchFaults, unsigned Opcode>
+void ParallelFaultSimulator::evaluateRun(size_t first, size_t end) {
+    const unsigned type = Opcode / 4;
+    const uint64_t neg1 = (Opcode & 2) ? ~uint64_t(0) : 0;
+    const uint64_t neg2 = (Opcode & 1) ? ~uint64_t(0) : 0;
+    for (size_t i = first; i < end; ++i) {
+        uint64_t in1 = values[netlist.gateInput1[i]];
+        uint64_t in2 = values[netlist.gateInput2[i]];
+        if (BranchFaults) {
+            in1 = (in1 & ~pinMask[2 * i]) | pinBits[2 * i];
+            in2 = (in2 & ~pinMask[2 * i + 1]) | pinBits[2 * i + 1];
+        }
+        const uint64_t val1 = in1 ^ neg1;
+        const uint64_t val2 = in2 ^ neg2;
+        const uint64_t result = type == Gate::AND ? (val1 & val2) : type == Gate::OR ? (val1 | val2)
+                              : type == Gate::NOT ? ~val1 : val1;
+        // Faulted lanes of the output wire keep their stuck value whatever the gate computes.
+        const uint32_t output = netlist.gateOutput[i];
+        values[output] = (result & ~forceMask[output]) | forceBits[output];
+    }
+}
+
+// Simulates one input pattern in all 64 machines and returns the lanes whose primary outputs differ from
+// the good machine in lane 0, i.e. bit i + 1 is set if the pattern detects fault i of the loaded group.
+uint64_t ParallelFaultSimulator::simulatePattern(const std::vector<bool>& inputValues) {
+    // Broadcast the pattern to all lanes, then apply the stuck lanes of faulted inputs.
+    for (size_t j = 0; j < netlist.inputIds.size(); ++j) {
+        const uint32_t wire = netlist.inputIds[j];
+        const uint64_t broadcast = inputValues[j] ? ~uint64_t(0) : uint64_t(0);
+        values[wire] = (broadcast & ~forceMask[wire]) | forceBits[wire];
+    }
+    // Wires without a driving gate (inputs and undriven wires, which read 0) only get their stuck lanes here.
+    for (uint32_t wire : forcedWires) {
+        if (netlist.driverGate[wire] == CompiledNetlist::NoGate) {
+            values[wire] = (values[wire] & ~forceMask[wire]) | forceBits[wire];
+        }
+    }
+    values[netlist.zeroWire] = 0;
+
+    INSTRUMENT_COUNT(GATE_EVALUATIONS, netlist.getNumGates());
+    if (forcedPins.empty()) {
+        evaluateGates<false>();
+    }
+    else {
+        evaluateGates<true>();
+    }
+
+    // A lane detects its fault if any output differs from the good machine's value, broadcast from lane 0.
+    uint64_t detected = 0;
+    for (uint32_t output : netlist.outputIds) {
+        const uint64_t word = values[output];
+        detected |= word ^ (0 - (word & 1));
+    }
+    return detected;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CompiledNetlist.h"
+#include "FaultSimulator.h"
+
+// Parallel-fault simulation: every bit lane of a 64-bit word is a separate machine for the same input pattern.
+// Lane 0 is the good machine and lanes 1..63 each carry one stuck-at fault, injected like Wire::setFault but as
+// per-lane force masks, so one pass over the compiled netlist grades 63 faults against one pattern.
+class ParallelFaultSimulator {
+public:
+    static const size_t FaultsPerPass = 63;
+
+    ParallelFaultSimulator(const CompiledNetlist& netlist);
+
+    void loadFaults(const StuckAtFault* faults, size_t count);
+    uint64_t simulatePattern(const std::vector<bool>& inputValues);
+
+private:
+    template <bool BranchFaults>
+    void evaluateGates();
+    template <bool BranchFaults, unsigned Opcode>
+    void evaluateRun(size_t first, size_t end);
+
+    const CompiledNetlist& netlist;
+    std::vector<uint64_t> values;
+    // Per wire: the lanes whose value is forced, and the forced values of those lanes.
+    std::vector<uint64_t> forceMask;
+    std::vector<uint64_t> forceBits;
+    std::vector<uint32_t> forcedWires;
+    // Per gate input pin (2 * gate + pin): the same masks for branch faults, which only that pin sees.
+    std::vector<uint64_t> pinMask;
+    std::vector<uint64_t> pinBits;
+    std::vector<uint32_t> forcedPins;
+};
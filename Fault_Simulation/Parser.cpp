@@ -1,9 +1,19 @@
 ﻿#include "Parser.h"
-#include <fstream>
-#include <sstream>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 
-Parser::Parser() {
+static bool isSpaceChar(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// The punctuation characters that end a name and form tokens of their own.
+static bool isSymbolChar(char c) {
+    return c == ',' || c == ';' || c == '=' || c == '&' || c == '|' || c == '~';
+}
+
+Parser::Parser()
+    : cursor(nullptr), end(nullptr), numNames(0), bytesParsed(0), parseSeconds(0.0) {
     
 }
 
@@ -12,242 +22,282 @@ Parser::~Parser() {
 }
 
 // Parses the file at the given filepath and updates the provided Circuit object based on the file's contents.
+// The file is memory-mapped and tokenized in a single pass: declarations create their wires right away,
+// while assign statements are collected and turned into gates once the whole file has been read, so an
+// assign may refer to a wire that is only declared further down (as the former two-pass reader allowed).
 void Parser::parse(const std::string& filepath, Circuit& circuit) {
-    std::ifstream file(filepath); // Opens the file for reading.
+    const auto start = std::chrono::steady_clock::now();
+    MappedFile file;
     // Check if the file opening was successful.
-    if (!file) {
+    if (!file.open(filepath)) {
         std::cerr << "Fehler beim Öffnen der Datei: " << filepath << std::endl; // Error message if file cannot be opened.
         return; // Exit the function if file cannot be opened.
     }
 
-    std::string line, partialLine; // Variables to hold the current line and a partial line accumulation.
-    // Read the file line by line.
-    while (std::getline(file, line)) {
-        // Skip lines starting with "//", "module", or "end;" as they are comments or not relevant for parsing.
-        if (line.find("//") == 0 || line.find("module") == 0 || line.find("end;") == 0) {
-            continue;
+    cursor = file.data();
+    end = file.data() + file.size();
+    // Size the tables for roughly one wire per 32 bytes of netlist text so that large files rarely rehash.
+    const size_t expectedWires = file.size() / 32 + 16;
+    size_t tableSize = 64;
+    while (tableSize < 2 * expectedWires) {
+        tableSize *= 2;
+    }
+    nameTable.assign(tableSize, NameSlot());
+    numNames = 0;
+    pendingAssigns.clear();
+    pendingAssigns.reserve(expectedWires);
+    circuit.wireIndex.reserve(circuit.wireIndex.size() + expectedWires);
+
+    // Every statement starts with a keyword; statements that are not relevant for the simulation
+    // (the module header and anything unknown) are skipped up to their closing semicolon.
+    NameRef token;
+    while (nextToken(token)) {
+        if (isKeyword(token, "input")) {
+            parseDeclaration(0, circuit);
+        } else if (isKeyword(token, "output")) {
+            parseDeclaration(1, circuit);
+        } else if (isKeyword(token, "wire")) {
+            parseDeclaration(2, circuit);
+        } else if (isKeyword(token, "assign")) {
+            parseAssign();
+        } else if (isKeyword(token, "endmodule")) {
+            continue; // "endmodule" is the only statement without a closing semicolon.
+        } else if (!isSymbol(token, ';')) {
+            skipStatement();
         }
-        
-        // Check if the line contains definitions for inputs, outputs, or wires, and if it does not end with a semicolon.
-        if (line.find("input") != std::string::npos) {
-            partialLine = line; // Start accumulating lines for a complete 'input' definition.
-            // Keep reading and appending lines until a semicolon is found, indicating the end of the definition.
-            while (partialLine.find(';') == std::string::npos && std::getline(file, line)) {
-                partialLine += " " + line; // Append the next line to the current accumulated definition.
-            }
-            parseInput(partialLine, circuit); // Parse the accumulated 'input' definition.
-            
-        } else if (line.find("output") != std::string::npos) {
-            partialLine = line; // Start accumulating lines for a complete 'output' definition.
-            while (partialLine.find(';') == std::string::npos && std::getline(file, line)) {
-                partialLine += " " + line; // Append the next line.
+    }
+
+    // Now that every wire is declared, create the gates in the order of their assign statements.
+    for (const PendingAssign& assign : pendingAssigns) {
+        buildGate(assign, circuit);
+    }
+
+    bytesParsed = file.size();
+    parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cursor = nullptr;
+    end = nullptr;
+    std::vector<NameSlot>().swap(nameTable);
+    numNames = 0;
+    std::vector<PendingAssign>().swap(pendingAssigns);
+}
+
+// Reads the next token: either a name or a single one of the characters , ; = & | ~.
+// Whitespace and // and /* */ comments are skipped. A name is any run of other characters, which also
+// covers escaped identifiers such as \1GAT(0) and \[0] with their leading backslash. Returns false at the end of the file.
+bool Parser::nextToken(NameRef& token) {
+    for (;;) {
+        while (cursor < end && isSpaceChar(*cursor)) {
+            ++cursor;
+        }
+        if (end - cursor >= 2 && cursor[0] == '/' && cursor[1] == '/') {
+            while (cursor < end && *cursor != '\n') {
+                ++cursor;
             }
-            parseOutput(partialLine, circuit); // Parse the accumulated 'output' definition.
-            
-        } else if (line.find("wire") != std::string::npos) {
-            partialLine = line; // Start accumulating lines for a complete 'wire' definition.
-            while (partialLine.find(';') == std::string::npos && std::getline(file, line)) {
-                partialLine += " " + line; // Append the next line.
+            continue;
+        }
+        if (end - cursor >= 2 && cursor[0] == '/' && cursor[1] == '*') {
+            cursor += 2;
+            while (end - cursor >= 2 && !(cursor[0] == '*' && cursor[1] == '/')) {
+                ++cursor;
             }
-            parseWire(partialLine, circuit); // Parse the accumulated 'wire' definition.
+            cursor = end - cursor >= 2 ? cursor + 2 : end;
+            continue;
         }
+        break;
     }
-    
-    // Reset the file stream to start reading the file again from the beginning.
-    file.clear(); // Clears any errors.
-    file.seekg(0); // Seeks back to the beginning of the file.
-
-    // Second pass: specifically looking for "assign" statements now that inputs, outputs, and wires have been parsed.
-    while (std::getline(file, line)) {
-        // Check if the line contains an 'assign' statement.
-        if (line.find("assign") != std::string::npos) {
-            partialLine = line; // Start accumulating lines for a complete 'assign' definition.
-            // Keep reading and appending lines until a semicolon is found, indicating the end of the definition.
-            while (partialLine.find(';') == std::string::npos && std::getline(file, line)) {
-                partialLine += " " + line; // Append the next line to the current accumulated definition.
-            }
-            parseAssign(partialLine, circuit); // Parse the accumulated 'assign' definition.
+    if (cursor >= end) {
+        return false;
+    }
+
+    token.begin = cursor;
+    if (isSymbolChar(*cursor)) {
+        ++cursor;
+    } else {
+        while (cursor < end && !isSpaceChar(*cursor) && !isSymbolChar(*cursor)) {
+            ++cursor;
         }
     }
+    token.length = static_cast<size_t>(cursor - token.begin);
+    return true;
 }
 
-// Parses a line from the file that specifies input pins for the circuit.
-void Parser::parseInput(const std::string& line, Circuit& circuit) {
-    // Search for the position of the "input" keyword in the line.
-    size_t inputPos = line.find("input");
-    // If "input" is found in the line, proceed with parsing.
-    if (inputPos != std::string::npos) {
-        // Extract the part of the line following "input", which contains the input definitions.
-        std::string inputs = line.substr(inputPos + 5); // Skip over the "input" keyword itself (+5 to move past it).
-        // Remove leading whitespace from the extracted part to get the clean input definitions.
-        inputs.erase(0, inputs.find_first_not_of(" \t\n"));
-
-        // Use a string stream to separate the inputs listed in the extracted string by commas.
-        std::istringstream iss(inputs);
-        std::string token; // Variable to hold each parsed input name.
+// Returns whether the token is a name rather than one of the punctuation characters.
+bool Parser::isName(const NameRef& token) const {
+    return token.length > 1 || !isSymbolChar(*token.begin);
+}
 
-        // Iterate through the extracted inputs, separated by commas.
-        while (std::getline(iss, token, ',')) {
-            // Trim whitespace and other characters from each input name.
-            token = trim(token);
+bool Parser::isSymbol(const NameRef& token, char symbol) const {
+    return token.length == 1 && *token.begin == symbol;
+}
 
-            // Check for and remove a trailing semicolon, which might be present after the last input definition.
-            size_t endPos = token.find(';');
-            if (endPos != std::string::npos) {
-                token = token.substr(0, endPos); // Remove the semicolon to clean up the input name.
-            }
+bool Parser::isKeyword(const NameRef& token, const char* keyword) const {
+    return token.length == std::strlen(keyword) && std::memcmp(token.begin, keyword, token.length) == 0;
+}
 
-            // Create a new wire for each input and add it to the circuit's list of inputs.
-            Wire* newWire = new Wire(token); // Instantiate a new wire object with the parsed input name.
-            circuit.addInput(newWire); // Add the newly created wire to the circuit as an input.
-            // Debugging message to console (commented out): indicates creation of a new input wire.
-            //std::cout << "Input Wire erstellt: " << token << std::endl;
+// Skips everything up to and including the next semicolon.
+void Parser::skipStatement() {
+    NameRef token;
+    while (nextToken(token)) {
+        if (isSymbol(token, ';')) {
+            return;
         }
     }
 }
 
-// Parses a line from the file that specifies output pins for the circuit.
-void Parser::parseOutput(const std::string& line, Circuit& circuit) {
-    size_t outputPos = line.find("output");
-    if (outputPos != std::string::npos) {
-        std::string outputs = line.substr(outputPos + 6);
-        outputs.erase(0, outputs.find_first_not_of(" \t\n"));
-        std::istringstream iss(outputs);
-        std::string token;
-        while (std::getline(iss, token, ',')) {
-            token = trim(token);
-            size_t endPos = token.find(';');
-            if (endPos != std::string::npos) {
-                token = token.substr(0, endPos);
-            }
-            Wire* newWire = new Wire(token);
+// Parses the comma-separated names of an input (kind 0), output (kind 1) or wire (kind 2) declaration
+// up to its semicolon and adds a new wire for each name to the circuit.
+void Parser::parseDeclaration(int kind, Circuit& circuit) {
+    NameRef token;
+    while (nextToken(token)) {
+        if (isSymbol(token, ';')) {
+            return;
+        }
+        if (!isName(token)) {
+            continue;
+        }
+        // Create a new wire for each name and add it to the circuit's list of its kind.
+        Wire* newWire = new Wire(std::string(token.begin, token.length));
+        if (kind == 0) {
+            circuit.addInput(newWire);
+        } else if (kind == 1) {
             circuit.addOutput(newWire);
-            // Debugging message to console (commented out): indicates creation of a new output wire.
-            //std::cout << "Output Wire erstellt: " << token << std::endl;
+        } else {
+            circuit.addInternalWire(newWire);
         }
+        declareWire(token, newWire, kind);
     }
 }
 
-// Parses a line from the file that specifies internal wires for the circuit.
-void Parser::parseWire(const std::string& line, Circuit& circuit) {
-    size_t wirePos = line.find("wire");
-    if (wirePos != std::string::npos) {
-        std::string wires = line.substr(wirePos + 4);
-        wires.erase(0, wires.find_first_not_of(" \t\n"));
-        std::istringstream iss(wires);
-        std::string token;
-        while (std::getline(iss, token, ',')) {
-            token = trim(token);
-            size_t endPos = token.find(';');
-            if (endPos != std::string::npos) {
-                token = token.substr(0, endPos);
-            }
-            Wire* newWire = new Wire(token);
-            circuit.addInternalWire(newWire);
-            // Debugging message to console (commented out): indicates creation of a new wire.
-            //std::cout << "Internal Wire erstellt: " << token << std::endl;
+// Parses "assign <output> = [~]<input1> [& or | [~]<input2>] ;" and keeps it for buildGate.
+void Parser::parseAssign() {
+    // Collect the tokens of the statement; a well-formed assign has at most seven.
+    const size_t maxTokens = 8;
+    NameRef tokens[maxTokens];
+    size_t count = 0;
+    NameRef token;
+    while (nextToken(token) && !isSymbol(token, ';')) {
+        if (count < maxTokens) {
+            tokens[count] = token;
         }
+        ++count;
     }
-}
-
-// Parses an assignment line to create and add a corresponding gate to the circuit.
-void Parser::parseAssign(const std::string& line, Circuit& circuit) {
-    // Create an input string stream from the part of the line after "assign".
-    std::istringstream iss(line.substr(line.find("assign") + 6)); // "+ 6" to skip over the word "assign".
-    std::string leftPart, rightPart; // To hold the gate output and input expressions.
 
-    // Split the line at the '=' to separate the gate output from its input expression.
-    std::getline(iss, leftPart, '=');
-    std::getline(iss, rightPart);
-
-    // Trim whitespace from around the gate output and input expressions.
-    leftPart = trim(leftPart);
-    rightPart = trim(rightPart);
+    PendingAssign assign = {};
+    size_t i = 0;
+    bool valid = count <= maxTokens && count >= 3 && isName(tokens[0]) && isSymbol(tokens[1], '=');
+    assign.output = tokens[0];
+    i = 2;
+    if (valid && isSymbol(tokens[i], '~')) {
+        assign.negInput1 = true;
+        ++i;
+    }
+    valid = valid && i < count && isName(tokens[i]);
+    if (valid) {
+        assign.input1 = tokens[i++];
+    }
+    if (valid && i < count) {
+        valid = isSymbol(tokens[i], '&') || isSymbol(tokens[i], '|');
+        assign.op = *tokens[i].begin;
+        assign.hasInput2 = true;
+        ++i;
+        if (valid && i < count && isSymbol(tokens[i], '~')) {
+            assign.negInput2 = true;
+            ++i;
+        }
+        valid = valid && i < count && isName(tokens[i]);
+        if (valid) {
+            assign.input2 = tokens[i++];
+        }
+    }
+    if (!valid || i != count) {
+        const std::string output = count > 0 ? std::string(tokens[0].begin, tokens[0].length) : std::string();
+        std::cerr << "Fehlerhafte assign-Anweisung für " << output << std::endl;
+        return;
+    }
+    pendingAssigns.push_back(assign);
+}
 
-    // Determine the type of gate based on the presence of logical operators in the input expression.
+// Creates the gate of an assign statement and adds it to the circuit.
+void Parser::buildGate(const PendingAssign& assign, Circuit& circuit) {
+    // Determine the type of gate based on the logical operator, or on the negation for single-input gates.
     Gate::GateType gateType;
-    char delimiter = ' '; // Initialize with a default value, not used directly.
-    // A flag to check if the gate could be either NOT or BUFFER, which don't use '&' or '|'.
-    bool isPossibleNotorBUFFER = rightPart.find("&") == std::string::npos && rightPart.find("|") == std::string::npos;
-    
-    if (rightPart.find("&") != std::string::npos) {
+    if (assign.op == '&') {
         gateType = Gate::AND; // Found an AND gate.
-        delimiter = '&';
-    } else if (rightPart.find("|") != std::string::npos) {
+    } else if (assign.op == '|') {
         gateType = Gate::OR; // Found an OR gate.
-        delimiter = '|';
-    } else if (isPossibleNotorBUFFER) {
-        // If neither '&' nor '|' is found, check for a NOT gate or assume BUFFER.
-        if (rightPart.find("~") != std::string::npos) {
-            gateType = Gate::NOT; // Found a NOT gate.
-            delimiter = 'N'; // Not used for NOT gates, but indicates negation.
-        } else {
-            gateType = Gate::BUFFER; // No operator found, assume BUFFER.
-            delimiter = 'B'; // Not used for BUFFER gates, but placeholder.
-        }
-    }
-
-    std::string input1, input2; // Variables to hold the names of the input wires.
-    Wire* wireInput1 = nullptr;
-    Wire* wireInput2 = nullptr;
-    bool negInput1 = false; // Flag to indicate if the first input is negated.
-    bool negInput2 = false; // Flag to indicate if the second input is negated.
-
-    // Parse the inputs based on the determined gate type.
-    if (gateType == Gate::AND || gateType == Gate::OR) {
-        // For AND and OR gates, split the input expression at the logical operator.
-        std::istringstream inout(rightPart);
-        std::getline(inout, input1, delimiter);
-        std::getline(inout, input2);
-        // Trim and check for negation in each input.
-        input1 = trim(input1);
-        input2 = trim(input2);
-        negInput1 = !input1.empty() && input1[0] == '~'; // Check if input1 starts with '~'.
-        if (negInput1) {
-            input1.erase(0, 1); // Remove '~' to clean the input name.
-        }
-        negInput2 = !input2.empty() && input2[0] == '~'; // Check if input2 starts with '~'.
-        if (negInput2) {
-            input2.erase(0, 1); // Remove '~' to clean the input name.
-        }
-        // Find or create the wires based on the input names.
-        wireInput1 = circuit.findWireByName(input1);
-        wireInput2 = circuit.findWireByName(input2);
-        
-    } else if (gateType == Gate::NOT || gateType == Gate::BUFFER) {
-        // For NOT and BUFFER gates, only one input is used.
-        // Check and handle negation for NOT gates; BUFFER gates do not use '~'.
-        negInput1 = !rightPart.empty() && rightPart[0] == '~';
-        if (negInput1) {
-            rightPart.erase(0, 1); // Remove '~' for NOT gates.
-        }
-        wireInput1 = circuit.findWireByName(trim(rightPart)); // Find or create the wire for the input.
+    } else if (assign.negInput1) {
+        gateType = Gate::NOT; // Found a NOT gate.
+    } else {
+        gateType = Gate::BUFFER; // No operator found, assume BUFFER.
     }
 
-    // Find or create the wire for the gate output.
-    Wire* wireOutput = circuit.findWireByName(leftPart);
+    Wire* wireInput1 = findWire(assign.input1);
+    Wire* wireInput2 = assign.hasInput2 ? findWire(assign.input2) : nullptr;
+    // Find the wire for the gate output.
+    Wire* wireOutput = findWire(assign.output);
     if (!wireOutput) {
-        std::cout << "leftPart nicht gefunden: " << leftPart << std::endl; // Error handling if output wire not found.
+        std::cout << "leftPart nicht gefunden: " << std::string(assign.output.begin, assign.output.length) << std::endl; // Error handling if output wire not found.
     }
     // If the necessary wires are found, create and add the gate to the circuit.
     if (wireOutput && wireInput1) {
-        Gate* newGate = new Gate(gateType, wireInput1, wireInput2, wireOutput, negInput1, negInput2);
+        Gate* newGate = new Gate(gateType, wireInput1, wireInput2, wireOutput, assign.negInput1, assign.negInput2);
         circuit.addGate(newGate); // Add the new gate to the circuit.
-        //std::cout << "Gate erstellt: " << wireOutput->getName() << std::endl; // Debugging message.
     }
 }
 
-// Removes leading and trailing whitespace and semicolons from the input string.
-std::string Parser::trim(const std::string& str) {
-    // Find the index of the first character that is not a space, tab, or newline.
-    size_t start = str.find_first_not_of(" \t\n");
-    // If such a character does not exist, the string is either empty or only contains whitespace.
-    if (start == std::string::npos) {
-        // In this case, return an empty string as there are no characters to keep.
-        return "";
+// Returns the slot holding the name, or the free slot where it belongs.
+Parser::NameSlot& Parser::findSlot(const NameRef& name, uint64_t hash) {
+    const size_t mask = nameTable.size() - 1;
+    for (size_t i = static_cast<size_t>(hash) & mask;; i = (i + 1) & mask) {
+        NameSlot& slot = nameTable[i];
+        if (!slot.wire || (slot.hash == hash && slot.name == name)) {
+            return slot;
+        }
+    }
+}
+
+// Enters a declared wire into the name table. A name declared more than once resolves like
+// Circuit::findWireByName: inputs before outputs before internal wires, and the first declaration within the same kind.
+void Parser::declareWire(const NameRef& name, Wire* wire, int kind) {
+    const uint64_t hash = hashName(name);
+    NameSlot& slot = findSlot(name, hash);
+    if (slot.wire) {
+        if (kind < slot.kind) {
+            slot.wire = wire;
+            slot.kind = kind;
+        }
+        return;
+    }
+    slot.hash = hash;
+    slot.name = name;
+    slot.wire = wire;
+    slot.kind = kind;
+    if (2 * ++numNames > nameTable.size()) {
+        // Keep the table at most half full: rehash every entry into a table of twice the size.
+        std::vector<NameSlot> oldTable(2 * nameTable.size(), NameSlot());
+        oldTable.swap(nameTable);
+        for (const NameSlot& entry : oldTable) {
+            if (entry.wire) {
+                findSlot(entry.name, entry.hash) = entry;
+            }
+        }
+    }
+}
+
+// Resolves a name to its declared wire through the name table, or returns nullptr for an undeclared name.
+Wire* Parser::findWire(const NameRef& name) {
+    return findSlot(name, hashName(name)).wire;
+}
+
+bool Parser::NameRef::operator==(const NameRef& other) const {
+    return length == other.length && std::memcmp(begin, other.begin, length) == 0;
+}
+
+// FNV-1a over the characters of the name.
+uint64_t Parser::hashName(const NameRef& name) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < name.length; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(name.begin[i])) * 1099511628211ULL;
     }
-    // Find the index of the last character that is not a space, tab, newline, or semicolon.
-    size_t end = str.find_last_not_of(" \t\n;");
-    // effectively removing any leading or trailing whitespace or semicolons.
-    return str.substr(start, end - start + 1);
+    return hash;
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 ﻿#pragma once
 #include "Circuit.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 class Parser
 {
@@ -9,10 +13,56 @@ public:
     void parse(const std::string& filepath, Circuit& circuit);
     ~Parser();
 
+    // Size of the last parsed file and the time parsing it took, for throughput reports.
+    size_t getBytesParsed() const { return bytesParsed; }
+    double getParseSeconds() const { return parseSeconds; }
+
 private:
-    void parseInput(const std::string& line, Circuit& circuit);
-    void parseOutput(const std::string& line, Circuit& circuit);
-    void parseWire(const std::string& line, Circuit& circuit);
-    void parseAssign(const std::string& line, Circuit& circuit);
-    std::string trim(const std::string& str);
+    // A name as it appears in the mapped file; names are only copied into a std::string when a wire is created.
+    struct NameRef {
+        const char* begin;
+        size_t length;
+
+        bool operator==(const NameRef& other) const;
+    };
+    // One slot of the open-addressing name table: a declared wire, the kind of its declaration
+    // (0 input, 1 output, 2 internal wire) and the hash of its name; wire is nullptr for free slots.
+    struct NameSlot {
+        uint64_t hash;
+        NameRef name;
+        Wire* wire;
+        int kind;
+    };
+    // An assign statement, kept until the whole file has been read so that its operands may be declared later.
+    struct PendingAssign {
+        NameRef output;
+        NameRef input1;
+        NameRef input2;
+        bool negInput1;
+        bool negInput2;
+        bool hasInput2;
+        char op;
+    };
+
+    bool nextToken(NameRef& token);
+    bool isName(const NameRef& token) const;
+    bool isSymbol(const NameRef& token, char symbol) const;
+    bool isKeyword(const NameRef& token, const char* keyword) const;
+    void skipStatement();
+    void parseDeclaration(int kind, Circuit& circuit);
+    void parseAssign();
+    void buildGate(const PendingAssign& assign, Circuit& circuit);
+    static uint64_t hashName(const NameRef& name);
+    NameSlot& findSlot(const NameRef& name, uint64_t hash);
+    void declareWire(const NameRef& name, Wire* wire, int kind);
+    Wire* findWire(const NameRef& name);
+
+    const char* cursor;
+    const char* end;
+    // Declared wires by name, a power-of-two sized table with linear probing that is kept at most half full.
+    std::vector<NameSlot> nameTable;
+    size_t numNames;
+    std::vector<PendingAssign> pendingAssigns;
+    size_t bytesParsed;
+    double parseSeconds;
 };
\ No newline at end of file
@@ -0,0 +1,395 @@
+#include "PatternKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FAULT_SIMULATION_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts the AVX intrinsics in any function, GCC and Clang need the target enabled per function
+// so that the rest of the program still runs on hosts without AVX.
+#if defined(_MSC_VER) || !defined(FAULT_SIMULATION_X86)
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+// Fallback kernel: one 64-bit word, i.e. 64 patterns per gate evaluation.
+static void evaluateGateScalar(Gate::GateType type, bool negInput1, bool negInput2,
+                               const uint64_t* input1, const uint64_t* input2, uint64_t* output) {
+    const uint64_t val1 = *input1 ^ (negInput1 ? ~uint64_t(0) : 0);
+    const uint64_t val2 = *input2 ^ (negInput2 ? ~uint64_t(0) : 0);
+    switch (type) {
+        case Gate::AND:
+            *output = val1 & val2;
+            break;
+        case Gate::OR:
+            *output = val1 | val2;
+            break;
+        case Gate::NOT:
+            *output = ~val1;
+            break;
+        case Gate::BUFFER:
+            *output = val1;
+            break;
+        default:
+            *output = 0;
+            break;
+    }
+}
+
+// Dual-rail fallback kernel. A negated pin reads its rails swapped; AND is definitely 1 where both pins are and
+// definitely 0 where either pin is, OR the other way round, and X stays X unless a controlling value decides.
+static void evaluateGateDualRailScalar(Gate::GateType type, bool negInput1, bool negInput2,
+                                       const uint64_t* input1, const uint64_t* input2, uint64_t* output) {
+    const uint64_t one1 = input1[negInput1 ? 1 : 0];
+    const uint64_t zero1 = input1[negInput1 ? 0 : 1];
+    const uint64_t one2 = input2[negInput2 ? 1 : 0];
+    const uint64_t zero2 = input2[negInput2 ? 0 : 1];
+    switch (type) {
+        case Gate::AND:
+            output[0] = one1 & one2;
+            output[1] = zero1 | zero2;
+            break;
+        case Gate::OR:
+            output[0] = one1 | one2;
+            output[1] = zero1 & zero2;
+            break;
+        case Gate::NOT:
+            output[0] = zero1;
+            output[1] = one1;
+            break;
+        case Gate::BUFFER:
+            output[0] = one1;
+            output[1] = zero1;
+            break;
+        default:
+            output[0] = 0;
+            output[1] = ~uint64_t(0);
+            break;
+    }
+}
+
+// Run kernels: one instantiation per opcode, so the gate type and the negations are constants the compiler folds
+// and the loop over the gates of a run is free of branches on them.
+template <Gate::GateType Type, bool Neg1, bool Neg2>
+static void evaluateGateRunScalar(const uint32_t* input1, const uint32_t* input2, const uint32_t* output,
+                                  size_t count, uint64_t* values) {
+    for (size_t k = 0; k < count; ++k) {
+        const uint64_t val1 = values[input1[k]] ^ (Neg1 ? ~uint64_t(0) : 0);
+        const uint64_t val2 = values[input2[k]] ^ (Neg2 ? ~uint64_t(0) : 0);
+        values[output[k]] = Type == Gate::AND ? (val1 & val2) : Type == Gate::OR ? (val1 | val2)
+                          : Type == Gate::NOT ? ~val1 : val1;
+    }
+}
+
+template <Gate::GateType Type, bool Neg1, bool Neg2>
+static void evaluateGateRunDualRailScalar(const uint32_t* input1, const uint32_t* input2, const uint32_t* output,
+                                          size_t count, uint64_t* values) {
+    for (size_t k = 0; k < count; ++k) {
+        const uint64_t* in1 = values + 2 * size_t(input1[k]);
+        const uint64_t* in2 = values + 2 * size_t(input2[k]);
+        const uint64_t one1 = in1[Neg1 ? 1 : 0];
+        const uint64_t zero1 = in1[Neg1 ? 0 : 1];
+        const uint64_t one2 = in2[Neg2 ? 1 : 0];
+        const uint64_t zero2 = in2[Neg2 ? 0 : 1];
+        uint64_t* out = values + 2 * size_t(output[k]);
+        out[0] = Type == Gate::AND ? (one1 & one2) : Type == Gate::OR ? (one1 | one2) : Type == Gate::NOT ? zero1 : one1;
+        out[1] = Type == Gate::AND ? (zero1 | zero2) : Type == Gate::OR ? (zero1 & zero2) : Type == Gate::NOT ? one1 : zero1;
+    }
+}
+
+#ifdef FAULT_SIMULATION_X86
+// AVX2 kernel: four 64-bit words, i.e. 256 patterns per gate evaluation.
+TARGET_AVX2 static void evaluateGateAvx2(Gate::GateType type, bool negInput1, bool negInput2,
+                                         const uint64_t* input1, const uint64_t* input2, uint64_t* output) {
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    const __m256i val1 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input1)),
+                                          negInput1 ? ones : _mm256_setzero_si256());
+    const __m256i val2 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input2)),
+                                          negInput2 ? ones : _mm256_setzero_si256());
+    __m256i result;
+    switch (type) {
+        case Gate::AND:
+            result = _mm256_and_si256(val1, val2);
+            break;
+        case Gate::OR:
+            result = _mm256_or_si256(val1, val2);
+            break;
+        case Gate::NOT:
+            result = _mm256_xor_si256(val1, ones);
+            break;
+        case Gate::BUFFER:
+            result = val1;
+            break;
+        default:
+            result = _mm256_setzero_si256();
+            break;
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), result);
+}
+
+// Dual-rail AVX2 kernel: 256 patterns per gate evaluation, each rail four words.
+TARGET_AVX2 static void evaluateGateDualRailAvx2(Gate::GateType type, bool negInput1, bool negInput2,
+                                                 const uint64_t* input1, const uint64_t* input2, uint64_t* output) {
+    const __m256i one1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input1 + (negInput1 ? 4 : 0)));
+    const __m256i zero1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input1 + (negInput1 ? 0 : 4)));
+    const __m256i one2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input2 + (negInput2 ? 4 : 0)));
+    const __m256i zero2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input2 + (negInput2 ? 0 : 4)));
+    __m256i one;
+    __m256i zero;
+    switch (type) {
+        case Gate::AND:
+            one = _mm256_and_si256(one1, one2);
+            zero = _mm256_or_si256(zero1, zero2);
+            break;
+        case Gate::OR:
+            one = _mm256_or_si256(one1, one2);
+            zero = _mm256_and_si256(zero1, zero2);
+            break;
+        case Gate::NOT:
+            one = zero1;
+            zero = one1;
+            break;
+        case Gate::BUFFER:
+            one = one1;
+            zero = zero1;
+            break;
+        default:
+            one = _mm256_setzero_si256();
+            zero = _mm256_set1_epi64x(-1);
+            break;
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), one);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + 4), zero);
+}
+
+// AVX2 run kernels, 256 patterns per gate.
+template <Gate::GateType Type, bool Neg1, bool Neg2>
+TARGET_AVX2 static void evaluateGateRunAvx2(const uint32_t* input1, const uint32_t* input2, const uint32_t* output,
+                                            size_t count, uint64_t* values) {
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    for (size_t k = 0; k < count; ++k) {
+        __m256i val1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + 4 * size_t(input1[k])));
+        __m256i val2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + 4 * size_t(input2[k])));
+        if (Neg1) {
+            val1 = _mm256_xor_si256(val1, ones);
+        }
+        if (Neg2) {
+            val2 = _mm256_xor_si256(val2, ones);
+        }
+        const __m256i result = Type == Gate::AND ? _mm256_and_si256(val1, val2)
+                             : Type == Gate::OR ? _mm256_or_si256(val1, val2)
+                             : Type == Gate::NOT ? _mm256_xor_si256(val1, ones) : val1;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + 4 * size_t(output[k])), result);
+    }
+}
+
+template <Gate::GateType Type, bool Neg1, bool Neg2>
+TARGET_AVX2 static void evaluateGateRunDualRailAvx2(const uint32_t* input1, const uint32_t* input2,
+                                                    const uint32_t* output, size_t count, uint64_t* values) {
+    for (size_t k = 0; k < count; ++k) {
+        const uint64_t* in1 = values + 8 * size_t(input1[k]);
+        const uint64_t* in2 = values + 8 * size_t(input2[k]);
+        const __m256i one1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in1 + (Neg1 ? 4 : 0)));
+        const __m256i zero1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in1 + (Neg1 ? 0 : 4)));
+        const __m256i one2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in2 + (Neg2 ? 4 : 0)));
+        const __m256i zero2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in2 + (Neg2 ? 0 : 4)));
+        const __m256i one = Type == Gate::AND ? _mm256_and_si256(one1, one2)
+                          : Type == Gate::OR ? _mm256_or_si256(one1, one2) : Type == Gate::NOT ? zero1 : one1;
+        const __m256i zero = Type == Gate::AND ? _mm256_or_si256(zero1, zero2)
+                           : Type == Gate::OR ? _mm256_and_si256(zero1, zero2) : Type == Gate::NOT ? one1 : zero1;
+        uint64_t* out = values + 8 * size_t(output[k]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), one);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4), zero);
+    }
+}
+
+// AVX-512 kernel: eight 64-bit words, i.e. 512 patterns per gate evaluation.
+TARGET_AVX512 static void evaluateGateAvx512(Gate::GateType type, bool negInput1, bool negInput2,
+                                             const uint64_t* input1, const uint64_t* input2, uint64_t* output) {
+    const __m512i ones = _mm512_set1_epi64(-1);
+    const __m512i val1 = _mm512_xor_si512(_mm512_loadu_si512(input1), negInput1 ? ones : _mm512_setzero_si512());
+    const __m512i val2 = _mm512_xor_si512(_mm512_loadu_si512(input2), negInput2 ? ones : _mm512_setzero_si512());
+    __m512i result;
+    switch (type) {
+        case Gate::AND:
+            result = _mm512_and_si512(val1, val2);
+            break;
+        case Gate::OR:
+            result = _mm512_or_si512(val1, val2);
+            break;
+        case Gate::NOT:
+            result = _mm512_xor_si512(val1, ones);
+            break;
+        case Gate::BUFFER:
+            result = val1;
+            break;
+        default:
+            result = _mm512_setzero_si512();
+            break;
+    }
+    _mm512_storeu_si512(output, result);
+}
+
+// Dual-rail AVX-512 kernel: 512 patterns per gate evaluation, each rail eight words.
+TARGET_AVX512 static void evaluateGateDualRailAvx512(Gate::GateType type, bool negInput1, bool negInput2,
+                                                     const uint64_t* input1, const uint64_t* input2, uint64_t* output) {
+    const __m512i one1 = _mm512_loadu_si512(input1 + (negInput1 ? 8 : 0));
+    const __m512i zero1 = _mm512_loadu_si512(input1 + (negInput1 ? 0 : 8));
+    const __m512i one2 = _mm512_loadu_si512(input2 + (negInput2 ? 8 : 0));
+    const __m512i zero2 = _mm512_loadu_si512(input2 + (negInput2 ? 0 : 8));
+    __m512i one;
+    __m512i zero;
+    switch (type) {
+        case Gate::AND:
+            one = _mm512_and_si512(one1, one2);
+            zero = _mm512_or_si512(zero1, zero2);
+            break;
+        case Gate::OR:
+            one = _mm512_or_si512(one1, one2);
+            zero = _mm512_and_si512(zero1, zero2);
+            break;
+        case Gate::NOT:
+            one = zero1;
+            zero = one1;
+            break;
+        case Gate::BUFFER:
+            one = one1;
+            zero = zero1;
+            break;
+        default:
+            one = _mm512_setzero_si512();
+            zero = _mm512_set1_epi64(-1);
+            break;
+    }
+    _mm512_storeu_si512(output, one);
+    _mm512_storeu_si512(output + 8, zero);
+}
+
+// AVX-512 run kernels, 512 patterns per gate.
+template <Gate::GateType Type, bool Neg1, bool Neg2>
+TARGET_AVX512 static void evaluateGateRunAvx512(const uint32_t* input1, const uint32_t* input2,
+                                                const uint32_t* output, size_t count, uint64_t* values) {
+    const __m512i ones = _mm512_set1_epi64(-1);
+    for (size_t k = 0; k < count; ++k) {
+        __m512i val1 = _mm512_loadu_si512(values + 8 * size_t(input1[k]));
+        __m512i val2 = _mm512_loadu_si512(values + 8 * size_t(input2[k]));
+        if (Neg1) {
+            val1 = _mm512_xor_si512(val1, ones);
+        }
+        if (Neg2) {
+            val2 = _mm512_xor_si512(val2, ones);
+        }
+        const __m512i result = Type == Gate::AND ? _mm512_and_si512(val1, val2)
+                             : Type == Gate::OR ? _mm512_or_si512(val1, val2)
+                             : Type == Gate::NOT ? _mm512_xor_si512(val1, ones) : val1;
+        _mm512_storeu_si512(values + 8 * size_t(output[k]), result);
+    }
+}
+
+template <Gate::GateType Type, bool Neg1, bool Neg2>
+TARGET_AVX512 static void evaluateGateRunDualRailAvx512(const uint32_t* input1, const uint32_t* input2,
+                                                        const uint32_t* output, size_t count, uint64_t* values) {
+    for (size_t k = 0; k < count; ++k) {
+        const uint64_t* in1 = values + 16 * size_t(input1[k]);
+        const uint64_t* in2 = values + 16 * size_t(input2[k]);
+        const __m512i one1 = _mm512_loadu_si512(in1 + (Neg1 ? 8 : 0));
+        const __m512i zero1 = _mm512_loadu_si512(in1 + (Neg1 ? 0 : 8));
+        const __m512i one2 = _mm512_loadu_si512(in2 + (Neg2 ? 8 : 0));
+        const __m512i zero2 = _mm512_loadu_si512(in2 + (Neg2 ? 0 : 8));
+        const __m512i one = Type == Gate::AND ? _mm512_and_si512(one1, one2)
+                          : Type == Gate::OR ? _mm512_or_si512(one1, one2) : Type == Gate::NOT ? zero1 : one1;
+        const __m512i zero = Type == Gate::AND ? _mm512_or_si512(zero1, zero2)
+                           : Type == Gate::OR ? _mm512_and_si512(zero1, zero2) : Type == Gate::NOT ? one1 : zero1;
+        uint64_t* out = values + 16 * size_t(output[k]);
+        _mm512_storeu_si512(out, one);
+        _mm512_storeu_si512(out + 8, zero);
+    }
+}
+#endif
+
+// The sixteen instantiations of a run kernel in opcode order (see Gate::getOpcode).
+#define GATE_RUN_KERNELS(kernel) { \
+    kernel<Gate::AND, false, false>, kernel<Gate::AND, false, true>, \
+    kernel<Gate::AND, true, false>, kernel<Gate::AND, true, true>, \
+    kernel<Gate::OR, false, false>, kernel<Gate::OR, false, true>, \
+    kernel<Gate::OR, true, false>, kernel<Gate::OR, true, true>, \
+    kernel<Gate::NOT, false, false>, kernel<Gate::NOT, false, true>, \
+    kernel<Gate::NOT, true, false>, kernel<Gate::NOT, true, true>, \
+    kernel<Gate::BUFFER, false, false>, kernel<Gate::BUFFER, false, true>, \
+    kernel<Gate::BUFFER, true, false>, kernel<Gate::BUFFER, true, true> }
+
+static const PatternKernels scalarKernels = {
+    PatternKernels::SCALAR, "scalar-u64", 1, evaluateGateScalar, evaluateGateDualRailScalar,
+    GATE_RUN_KERNELS(evaluateGateRunScalar), GATE_RUN_KERNELS(evaluateGateRunDualRailScalar)
+};
+#ifdef FAULT_SIMULATION_X86
+static const PatternKernels avx2Kernels = {
+    PatternKernels::AVX2, "avx2", 4, evaluateGateAvx2, evaluateGateDualRailAvx2,
+    GATE_RUN_KERNELS(evaluateGateRunAvx2), GATE_RUN_KERNELS(evaluateGateRunDualRailAvx2)
+};
+static const PatternKernels avx512Kernels = {
+    PatternKernels::AVX512, "avx512", 8, evaluateGateAvx512, evaluateGateDualRailAvx512,
+    GATE_RUN_KERNELS(evaluateGateRunAvx512), GATE_RUN_KERNELS(evaluateGateRunDualRailAvx512)
+};
+#endif
+
+// Checks with CPUID (and the OS-enabled register state) whether the host can execute the given kernel set.
+bool isIsaSupported(PatternKernels::IsaLevel isa) {
+    if (isa == PatternKernels::SCALAR) {
+        return true;
+    }
+#if defined(FAULT_SIMULATION_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+    if (!osSavesYmm) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    if (isa == PatternKernels::AVX2) {
+        return (info[1] & (1 << 5)) != 0;
+    }
+    // AVX-512 additionally needs the opmask and upper ZMM register state enabled by the OS.
+    return (info[1] & (1 << 16)) != 0 && (_xgetbv(0) & 0xE6) == 0xE6;
+#elif defined(FAULT_SIMULATION_X86)
+    __builtin_cpu_init();
+    if (isa == PatternKernels::AVX2) {
+        return __builtin_cpu_supports("avx2");
+    }
+    return __builtin_cpu_supports("avx512f");
+#else
+    return false;
+#endif
+}
+
+// Returns the kernel set of the given level. Levels the build does not contain fall back to the scalar kernels.
+const PatternKernels& getPatternKernels(PatternKernels::IsaLevel isa) {
+#ifdef FAULT_SIMULATION_X86
+    if (isa == PatternKernels::AVX512) {
+        return avx512Kernels;
+    }
+    if (isa == PatternKernels::AVX2) {
+        return avx2Kernels;
+    }
+#endif
+    return scalarKernels;
+}
+
+// Picks the widest kernel set the host supports. The CPUID check runs only once, on first use at startup.
+const PatternKernels& selectPatternKernels() {
+    static const PatternKernels& selected =
+        isIsaSupported(PatternKernels::AVX512) ? getPatternKernels(PatternKernels::AVX512) :
+        isIsaSupported(PatternKernels::AVX2) ? getPatternKernels(PatternKernels::AVX2) :
+        getPatternKernels(PatternKernels::SCALAR);
+    return selected;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Gate.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Number of set bits in a 64-bit lane mask.
+inline unsigned countSetLanes(uint64_t lanes) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<unsigned>(__popcnt64(lanes));
+#elif defined(_MSC_VER)
+    return static_cast<unsigned>(__popcnt(static_cast<unsigned>(lanes)) + __popcnt(static_cast<unsigned>(lanes >> 32)));
+#else
+    return static_cast<unsigned>(__builtin_popcountll(lanes));
+#endif
+}
+
+// Index of the lowest set bit of a non-zero 64-bit lane mask.
+inline unsigned lowestSetLane(uint64_t lanes) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, lanes);
+    return static_cast<unsigned>(index);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<unsigned long>(lanes))) {
+        return static_cast<unsigned>(index);
+    }
+    _BitScanForward(&index, static_cast<unsigned long>(lanes >> 32));
+    return static_cast<unsigned>(index) + 32;
+#else
+    return static_cast<unsigned>(__builtin_ctzll(lanes));
+#endif
+}
+
+// Mask of the valid lanes of word 'wordIndex' in a pattern block that holds 'numPatterns' patterns.
+inline uint64_t validLaneMask(size_t numPatterns, size_t wordIndex) {
+    if (numPatterns <= 64 * wordIndex) {
+        return 0;
+    }
+    const size_t lanes = numPatterns - 64 * wordIndex;
+    return lanes >= 64 ? ~uint64_t(0) : ((uint64_t(1) << lanes) - 1);
+}
+
+// Returns the 64 pattern lanes of input 'inputIndex' (below 64) for the exhaustive combinations base .. base+63.
+// Lane l holds bit 'inputIndex' of combination (base + l); base is always a multiple of 64.
+inline uint64_t exhaustiveInputWord(uint64_t base, size_t inputIndex) {
+    // The lowest six input bits toggle inside a word, every higher bit is constant across the 64 lanes.
+    static const uint64_t laneMasks[6] = {
+        0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+        0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+    };
+    if (inputIndex < 6) {
+        return laneMasks[inputIndex];
+    }
+    return ((base >> inputIndex) & 1) ? ~uint64_t(0) : uint64_t(0);
+}
+
+// Evaluates a run of 'count' gates of one opcode (see Gate::getOpcode) on a value array holding a block of
+// 'blockWords' words per wire, or two in dual-rail form. The gates' wire ids are given by the three arrays.
+typedef void (*GateRunKernel)(const uint32_t* input1, const uint32_t* input2, const uint32_t* output, size_t count,
+                              uint64_t* values);
+
+// A set of pattern-parallel gate kernels for one instruction set level.
+// Every kernel evaluates a gate over a block of 'blockWords' 64-bit words, i.e. 64 * blockWords patterns per call.
+struct PatternKernels {
+    enum IsaLevel { SCALAR, AVX2, AVX512 };
+
+    IsaLevel isa;
+    const char* name;
+    size_t blockWords;
+    // Computes output = type(input1 ^ neg1, input2 ^ neg2) for one block; input2 is ignored for NOT and BUFFER.
+    void (*evaluateGate)(Gate::GateType type, bool negInput1, bool negInput2,
+                         const uint64_t* input1, const uint64_t* input2, uint64_t* output);
+    // The same in three-valued dual-rail form: each operand is a block of 'blockWords' words whose lanes are
+    // definitely 1, followed by a block whose lanes are definitely 0; a lane set in neither rail is X.
+    void (*evaluateGateDualRail)(Gate::GateType type, bool negInput1, bool negInput2,
+                                 const uint64_t* input1, const uint64_t* input2, uint64_t* output);
+    // Run kernels indexed by opcode, each compiled for its gate type and negations, so the loop over a run
+    // carries no branch on them. Two-valued and dual-rail.
+    GateRunKernel evaluateGateRun[Gate::NumOpcodes];
+    GateRunKernel evaluateGateRunDualRail[Gate::NumOpcodes];
+};
+
+bool isIsaSupported(PatternKernels::IsaLevel isa);
+const PatternKernels& getPatternKernels(PatternKernels::IsaLevel isa);
+const PatternKernels& selectPatternKernels();
@@ -0,0 +1,475 @@
+#include "Podem.h"
+#include <algorithm>
+
+const int8_t Podem::Unassigned;
+const uint8_t Podem::LogicX;
+const uint32_t Podem::NoInput;
+
+// SCOAP measure of something that cannot be achieved; sums saturate there.
+static const uint32_t Unreachable = 1u << 28;
+
+static uint32_t addMeasures(uint32_t a, uint32_t b) {
+    return std::min(a + b, Unreachable);
+}
+
+Podem::Podem(const CompiledNetlist& netlist)
+    : netlist(netlist),
+      backtrackLimit(100),
+      visitEpoch(0),
+      coneEpoch(0)
+{
+    const size_t numWires = netlist.getNumWires();
+    inputIndex.assign(numWires, NoInput);
+    for (size_t i = 0; i < netlist.inputIds.size(); ++i) {
+        inputIndex[netlist.inputIds[i]] = static_cast<uint32_t>(i);
+    }
+    computeTestability();
+
+    // With every input unassigned, undriven wires and the constant-0 source read 0 as in the compiled simulation.
+    good.assign(numWires, 0);
+    faulty.assign(numWires, 0);
+    for (uint32_t input : netlist.inputIds) {
+        good[input] = LogicX;
+    }
+    for (uint32_t g = 0; g < netlist.getNumGates(); ++g) {
+        good[netlist.gateOutput[g]] = evaluateGate(g, false);
+    }
+    initialValues = good;
+
+    visitMark.assign(numWires, 0);
+    coneMark.assign(numWires, 0);
+    levelQueues.resize(netlist.numLevels);
+    queued.assign(netlist.getNumGates(), 0);
+}
+
+// Sets how many backtracks a fault may take before its search is aborted.
+void Podem::setBacktrackLimit(size_t limit) {
+    backtrackLimit = limit;
+}
+
+// Computes the SCOAP combinational controllabilities (inputs cost 1, every gate adds 1) in evaluation order and
+// the observabilities (outputs cost 0) in reverse order, following the negated inputs of the compiled gates.
+void Podem::computeTestability() {
+    const size_t numWires = netlist.getNumWires();
+    const uint32_t numGates = static_cast<uint32_t>(netlist.getNumGates());
+    // Undriven wires are constant 0.
+    cc0.assign(numWires, 0);
+    cc1.assign(numWires, Unreachable);
+    for (uint32_t input : netlist.inputIds) {
+        cc0[input] = 1;
+        cc1[input] = 1;
+    }
+    // Controllability of the value a gate pin sees after its negation.
+    auto pinControllability = [this](uint32_t wire, bool negated, bool value) {
+        return (value != negated) ? cc1[wire] : cc0[wire];
+    };
+    for (uint32_t g = 0; g < numGates; ++g) {
+        const uint32_t a = netlist.gateInput1[g];
+        const uint32_t b = netlist.gateInput2[g];
+        const bool negA = netlist.negInput1[g] != 0;
+        const bool negB = netlist.negInput2[g] != 0;
+        const uint32_t output = netlist.gateOutput[g];
+        switch (netlist.gateType[g]) {
+            case Gate::AND:
+                cc0[output] = addMeasures(std::min(pinControllability(a, negA, false), pinControllability(b, negB, false)), 1);
+                cc1[output] = addMeasures(addMeasures(pinControllability(a, negA, true), pinControllability(b, negB, true)), 1);
+                break;
+            case Gate::OR:
+                cc0[output] = addMeasures(addMeasures(pinControllability(a, negA, false), pinControllability(b, negB, false)), 1);
+                cc1[output] = addMeasures(std::min(pinControllability(a, negA, true), pinControllability(b, negB, true)), 1);
+                break;
+            case Gate::NOT:
+                cc0[output] = addMeasures(pinControllability(a, negA, true), 1);
+                cc1[output] = addMeasures(pinControllability(a, negA, false), 1);
+                break;
+            default:
+                cc0[output] = addMeasures(pinControllability(a, negA, false), 1);
+                cc1[output] = addMeasures(pinControllability(a, negA, true), 1);
+                break;
+        }
+    }
+
+    co.assign(numWires, Unreachable);
+    for (uint32_t output : netlist.outputIds) {
+        co[output] = 0;
+    }
+    for (uint32_t g = numGates; g-- > 0;) {
+        const uint32_t observability = co[netlist.gateOutput[g]];
+        if (observability >= Unreachable) {
+            continue;
+        }
+        const uint8_t type = netlist.gateType[g];
+        const uint32_t pins[2] = { netlist.gateInput1[g], netlist.gateInput2[g] };
+        const bool neg[2] = { netlist.negInput1[g] != 0, netlist.negInput2[g] != 0 };
+        for (int pin = 0; pin < ((type == Gate::AND || type == Gate::OR) ? 2 : 1); ++pin) {
+            uint32_t pinObservability = addMeasures(observability, 1);
+            if (type == Gate::AND || type == Gate::OR) {
+                // The other pin has to hold the non-controlling value.
+                const int other = 1 - pin;
+                pinObservability = addMeasures(pinObservability, pinControllability(pins[other], neg[other], type == Gate::AND));
+            }
+            if (pins[pin] != netlist.zeroWire) {
+                co[pins[pin]] = std::min(co[pins[pin]], pinObservability);
+            }
+        }
+    }
+}
+
+// Generates a test for the fault. On TEST_FOUND 'cube' holds 0, 1 or Unassigned for every primary input, and
+// every way of filling the unassigned inputs detects the fault.
+Podem::Result Podem::generateTest(const StuckAtFault& target, std::vector<int8_t>& cube) {
+    prepareFault(target);
+    size_t backtracks = 0;
+    for (;;) {
+        if (isDetected()) {
+            cube.assign(netlist.inputIds.size(), Unassigned);
+            for (size_t i = 0; i < netlist.inputIds.size(); ++i) {
+                if (good[netlist.inputIds[i]] != LogicX) {
+                    cube[i] = static_cast<int8_t>(good[netlist.inputIds[i]]);
+                }
+            }
+            return TEST_FOUND;
+        }
+
+        uint32_t wire;
+        uint8_t value;
+        if (getObjective(wire, value)) {
+            uint32_t input;
+            uint8_t inputValue;
+            if (!backtrace(wire, value, input, inputValue)) {
+                // The objective leads to no unassigned input; decide on the first free one so the search stays complete.
+                input = NoInput;
+                for (size_t i = 0; i < netlist.inputIds.size() && input == NoInput; ++i) {
+                    if (good[netlist.inputIds[i]] == LogicX) {
+                        input = static_cast<uint32_t>(i);
+                    }
+                }
+                inputValue = 0;
+            }
+            if (input != NoInput) {
+                decisions.push_back({ input, inputValue, false });
+                assignInput(input, inputValue);
+                continue;
+            }
+        }
+
+        // No test below the current decisions: undo the decisions whose both values failed and flip the latest other one.
+        while (!decisions.empty() && decisions.back().flipped) {
+            assignInput(decisions.back().input, LogicX);
+            decisions.pop_back();
+        }
+        if (decisions.empty()) {
+            return REDUNDANT;
+        }
+        if (++backtracks > backtrackLimit) {
+            return ABORTED;
+        }
+        Decision& decision = decisions.back();
+        decision.value ^= 1;
+        decision.flipped = true;
+        assignInput(decision.input, decision.value);
+    }
+}
+
+// Merges 'cube' into 'into' when no input is assigned opposite values in the two. The merged cube refines both,
+// so every fill of it still detects the faults of both cubes. Leaves 'into' unchanged when they conflict.
+bool Podem::mergeCubes(std::vector<int8_t>& into, const std::vector<int8_t>& cube) {
+    for (size_t i = 0; i < cube.size(); ++i) {
+        if (cube[i] != Unassigned && into[i] != Unassigned && cube[i] != into[i]) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < cube.size(); ++i) {
+        if (cube[i] != Unassigned) {
+            into[i] = cube[i];
+        }
+    }
+    return true;
+}
+
+// Resets both machines to all inputs unassigned, injects the fault and finds the outputs it can reach.
+void Podem::prepareFault(const StuckAtFault& target) {
+    fault = target;
+    decisions.clear();
+    good = initialValues;
+    faulty = initialValues;
+
+    // The fanout cone of the fault site: only its wires can differ between the machines, and only its primary
+    // outputs can show the fault effect.
+    ++visitEpoch;
+    coneEpoch = visitEpoch;
+    coneOutputs.clear();
+    pathStack.assign(1, fault.isBranch() ? netlist.gateOutput[fault.gate] : fault.wire);
+    coneMark[pathStack[0]] = coneEpoch;
+    while (!pathStack.empty()) {
+        const uint32_t wire = pathStack.back();
+        pathStack.pop_back();
+        if (netlist.isOutput[wire]) {
+            coneOutputs.push_back(wire);
+        }
+        for (uint32_t i = netlist.fanoutStart[wire]; i < netlist.fanoutStart[wire + 1]; ++i) {
+            const uint32_t output = netlist.gateOutput[netlist.fanoutGates[i]];
+            if (coneMark[output] != coneEpoch) {
+                coneMark[output] = coneEpoch;
+                pathStack.push_back(output);
+            }
+        }
+    }
+
+    if (fault.isBranch()) {
+        levelQueues[netlist.gateLevel[fault.gate]].push_back(fault.gate);
+        queued[fault.gate] = 1;
+    } else {
+        faulty[fault.wire] = fault.value ? 1 : 0;
+        scheduleFanout(fault.wire);
+    }
+    implicate();
+}
+
+// Sets a primary input (or unassigns it with LogicX) in both machines and implies the consequences.
+void Podem::assignInput(uint32_t input, uint8_t value) {
+    const uint32_t wire = netlist.inputIds[input];
+    good[wire] = value;
+    faulty[wire] = (!fault.isBranch() && fault.wire == wire) ? (fault.value ? 1 : 0) : value;
+    scheduleFanout(wire);
+    implicate();
+}
+
+void Podem::scheduleFanout(uint32_t wire) {
+    for (uint32_t i = netlist.fanoutStart[wire]; i < netlist.fanoutStart[wire + 1]; ++i) {
+        const uint32_t gate = netlist.fanoutGates[i];
+        if (!queued[gate]) {
+            queued[gate] = 1;
+            levelQueues[netlist.gateLevel[gate]].push_back(gate);
+        }
+    }
+}
+
+// Re-evaluates the scheduled gates level by level and schedules the readers of every output that changed.
+// Outside the fanout cone of the fault the faulty machine equals the good one and is not evaluated separately.
+void Podem::implicate() {
+    for (uint32_t level = 0; level < netlist.numLevels; ++level) {
+        std::vector<uint32_t>& queue = levelQueues[level];
+        for (size_t i = 0; i < queue.size(); ++i) {
+            const uint32_t gate = queue[i];
+            queued[gate] = 0;
+            const uint32_t output = netlist.gateOutput[gate];
+            const uint8_t goodValue = evaluateGate(gate, false);
+            uint8_t faultyValue = goodValue;
+            if (!fault.isBranch() && fault.wire == output) {
+                faultyValue = fault.value ? 1 : 0;
+            } else if (coneMark[output] == coneEpoch) {
+                faultyValue = evaluateGate(gate, true);
+            }
+            if (goodValue != good[output] || faultyValue != faulty[output]) {
+                good[output] = goodValue;
+                faulty[output] = faultyValue;
+                scheduleFanout(output);
+            }
+        }
+        queue.clear();
+    }
+}
+
+// Three-valued truth tables indexed by 0, 1 and LogicX.
+static const uint8_t NotTable[3] = { 1, 0, Podem::LogicX };
+static const uint8_t AndTable[3][3] = { { 0, 0, 0 }, { 0, 1, Podem::LogicX }, { 0, Podem::LogicX, Podem::LogicX } };
+static const uint8_t OrTable[3][3] = { { 0, 1, Podem::LogicX }, { 1, 1, 1 }, { Podem::LogicX, 1, Podem::LogicX } };
+
+// The value gate pin 'pin' sees after its negation, in the good or the faulty machine.
+uint8_t Podem::readPin(uint32_t gate, uint8_t pin, bool faultyMachine) const {
+    const uint32_t wire = pin == 0 ? netlist.gateInput1[gate] : netlist.gateInput2[gate];
+    uint8_t value = faultyMachine ? faulty[wire] : good[wire];
+    if (faultyMachine && fault.isBranch() && fault.gate == gate && fault.pin == pin) {
+        value = fault.value ? 1 : 0;
+    }
+    return (pin == 0 ? netlist.negInput1[gate] : netlist.negInput2[gate]) ? NotTable[value] : value;
+}
+
+// Three-valued evaluation of a compiled gate: out = type(in1 ^ neg1, in2 ^ neg2).
+uint8_t Podem::evaluateGate(uint32_t gate, bool faultyMachine) const {
+    const uint8_t a = readPin(gate, 0, faultyMachine);
+    switch (netlist.gateType[gate]) {
+        case Gate::AND:
+            return AndTable[a][readPin(gate, 1, faultyMachine)];
+        case Gate::OR:
+            return OrTable[a][readPin(gate, 1, faultyMachine)];
+        case Gate::NOT:
+            return NotTable[a];
+        default:
+            return a;
+    }
+}
+
+bool Podem::isDetected() const {
+    for (uint32_t output : coneOutputs) {
+        if (good[output] != LogicX && faulty[output] != LogicX && good[output] != faulty[output]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A gate is in the D-frontier when one of its pins carries the fault effect but its output is still unknown.
+bool Podem::isDFrontier(uint32_t gate) const {
+    const uint8_t type = netlist.gateType[gate];
+    const uint32_t output = netlist.gateOutput[gate];
+    if ((type != Gate::AND && type != Gate::OR) || !isUnknown(output)
+        || (!fault.isBranch() && fault.wire == output)) {
+        return false;
+    }
+    for (uint8_t pin = 0; pin < 2; ++pin) {
+        const uint8_t goodValue = readPin(gate, pin, false);
+        const uint8_t faultyValue = readPin(gate, pin, true);
+        if (goodValue != LogicX && faultyValue != LogicX && goodValue != faultyValue) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Podem::collectDFrontier() {
+    dFrontier.clear();
+    ++visitEpoch;
+    pathStack.clear();
+    auto examineGate = [this](uint32_t gate) {
+        const uint32_t output = netlist.gateOutput[gate];
+        if (isUnknown(output)) {
+            if (isDFrontier(gate)) {
+                dFrontier.push_back(gate);
+            }
+        } else if (good[output] != faulty[output] && visitMark[output] != visitEpoch) {
+            visitMark[output] = visitEpoch;
+            pathStack.push_back(output);
+        }
+    };
+    if (fault.isBranch()) {
+        examineGate(fault.gate);
+    } else {
+        visitMark[fault.wire] = visitEpoch;
+        pathStack.push_back(fault.wire);
+    }
+    while (!pathStack.empty()) {
+        const uint32_t wire = pathStack.back();
+        pathStack.pop_back();
+        for (uint32_t i = netlist.fanoutStart[wire]; i < netlist.fanoutStart[wire + 1]; ++i) {
+            examineGate(netlist.fanoutGates[i]);
+        }
+    }
+}
+
+// Whether a path of unknown wires leads from 'wire' to a primary output, so the fault effect can still get there.
+bool Podem::hasXPath(uint32_t wire) {
+    ++visitEpoch;
+    pathStack.assign(1, wire);
+    visitMark[wire] = visitEpoch;
+    while (!pathStack.empty()) {
+        const uint32_t current = pathStack.back();
+        pathStack.pop_back();
+        if (netlist.isOutput[current]) {
+            return true;
+        }
+        for (uint32_t i = netlist.fanoutStart[current]; i < netlist.fanoutStart[current + 1]; ++i) {
+            const uint32_t output = netlist.gateOutput[netlist.fanoutGates[i]];
+            if (visitMark[output] != visitEpoch && isUnknown(output)) {
+                visitMark[output] = visitEpoch;
+                pathStack.push_back(output);
+            }
+        }
+    }
+    return false;
+}
+
+// The next value to justify: the fault site at the opposite of the stuck value while the fault is not active,
+// then the non-controlling value on an unknown pin of the most observable D-frontier gate with an X-path.
+// Returns false when the current decisions cannot lead to a test.
+bool Podem::getObjective(uint32_t& wire, uint8_t& value) {
+    const uint8_t site = good[fault.wire];
+    if (site == LogicX) {
+        wire = fault.wire;
+        value = fault.value ? 0 : 1;
+        return true;
+    }
+    if (site == (fault.value ? 1 : 0)) {
+        return false;
+    }
+
+    // Walk the fault effect from the site through the wires on which the two machines differ; the gates reading
+    // them with a still unknown output form the D-frontier.
+    collectDFrontier();
+    uint32_t best = CompiledNetlist::NoGate;
+    uint32_t bestObservability = Unreachable + 1;
+    for (uint32_t gate : dFrontier) {
+        const uint32_t output = netlist.gateOutput[gate];
+        if (co[output] < bestObservability && hasXPath(output)) {
+            best = gate;
+            bestObservability = co[output];
+        }
+    }
+    if (best == CompiledNetlist::NoGate) {
+        return false;
+    }
+    const uint8_t nonControlling = netlist.gateType[best] == Gate::AND ? 1 : 0;
+    const uint32_t pins[2] = { netlist.gateInput1[best], netlist.gateInput2[best] };
+    const bool neg[2] = { netlist.negInput1[best] != 0, netlist.negInput2[best] != 0 };
+    uint32_t bestControllability = Unreachable + 1;
+    for (int pin = 0; pin < 2; ++pin) {
+        if (pins[pin] == netlist.zeroWire || !isUnknown(pins[pin])) {
+            continue;
+        }
+        const uint8_t required = static_cast<uint8_t>(nonControlling ^ (neg[pin] ? 1 : 0));
+        const uint32_t controllability = required ? cc1[pins[pin]] : cc0[pins[pin]];
+        if (controllability < bestControllability) {
+            wire = pins[pin];
+            value = required;
+            bestControllability = controllability;
+        }
+    }
+    return bestControllability <= Unreachable;
+}
+
+// Follows the objective back through unknown wires to an unassigned primary input. Where one pin decides the
+// gate output, the easiest pin to control is followed; where every pin must hold its non-controlling value,
+// the hardest one is, so that a conflict shows up early.
+bool Podem::backtrace(uint32_t wire, uint8_t value, uint32_t& input, uint8_t& inputValue) const {
+    for (;;) {
+        const uint32_t gate = netlist.driverGate[wire];
+        if (gate == CompiledNetlist::NoGate) {
+            input = inputIndex[wire];
+            inputValue = value;
+            return input != NoInput && good[wire] == LogicX;
+        }
+        const uint8_t type = netlist.gateType[gate];
+        const uint32_t pins[2] = { netlist.gateInput1[gate], netlist.gateInput2[gate] };
+        const bool neg[2] = { netlist.negInput1[gate] != 0, netlist.negInput2[gate] != 0 };
+        if (type != Gate::AND && type != Gate::OR) {
+            // NOT and BUFFER: the pin value follows from the output value.
+            const uint8_t pinValue = type == Gate::NOT ? static_cast<uint8_t>(value ^ 1) : value;
+            wire = pins[0];
+            value = static_cast<uint8_t>(pinValue ^ (neg[0] ? 1 : 0));
+            continue;
+        }
+        const uint8_t controlling = type == Gate::AND ? 0 : 1;
+        // AND outputs 0 and OR outputs 1 when any pin is controlling.
+        const bool anyPin = value == controlling;
+        const uint8_t pinValue = anyPin ? controlling : static_cast<uint8_t>(controlling ^ 1);
+        int chosen = -1;
+        uint32_t chosenControllability = 0;
+        for (int pin = 0; pin < 2; ++pin) {
+            if (pins[pin] == netlist.zeroWire || !isUnknown(pins[pin])) {
+                continue;
+            }
+            const uint8_t required = static_cast<uint8_t>(pinValue ^ (neg[pin] ? 1 : 0));
+            const uint32_t controllability = required ? cc1[pins[pin]] : cc0[pins[pin]];
+            if (chosen < 0 || (anyPin ? controllability < chosenControllability : controllability > chosenControllability)) {
+                chosen = pin;
+                chosenControllability = controllability;
+            }
+        }
+        if (chosen < 0) {
+            return false;
+        }
+        wire = pins[chosen];
+        value = static_cast<uint8_t>(pinValue ^ (neg[chosen] ? 1 : 0));
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CompiledNetlist.h"
+#include "FaultSimulator.h"
+
+// Deterministic test generation for single stuck-at faults with PODEM (path-oriented decision making).
+// Decisions are only made on primary inputs: an objective (activate the fault, or push its effect through a
+// gate of the D-frontier) is backtraced to an unassigned input, which is assigned and implied by three-valued
+// event-driven simulation of the good and the faulty machine. The SCOAP controllability and observability
+// measures guide both the choice of the D-frontier gate and the backtrace. When every decision has been tried
+// both ways the fault is redundant; the search is given up after a limit of backtracks.
+class Podem {
+public:
+    enum Result { TEST_FOUND, REDUNDANT, ABORTED };
+
+    // Value of an input the test cube leaves unassigned.
+    static const int8_t Unassigned = -1;
+
+    explicit Podem(const CompiledNetlist& netlist);
+
+    void setBacktrackLimit(size_t limit);
+    Result generateTest(const StuckAtFault& fault, std::vector<int8_t>& cube);
+    static bool mergeCubes(std::vector<int8_t>& into, const std::vector<int8_t>& cube);
+
+    // SCOAP measures of a wire: the effort to set it to 0 or 1, and to observe it at a primary output.
+    uint32_t getControllability(uint32_t wire, bool value) const { return value ? cc1[wire] : cc0[wire]; }
+    uint32_t getObservability(uint32_t wire) const { return co[wire]; }
+
+    // Unknown value in the three-valued simulation.
+    static const uint8_t LogicX = 2;
+
+private:
+    static const uint32_t NoInput = 0xFFFFFFFFu;
+
+    // A primary input decision; 'flipped' once its other value has been tried as well.
+    struct Decision {
+        uint32_t input;
+        uint8_t value;
+        bool flipped;
+    };
+
+    void computeTestability();
+    void prepareFault(const StuckAtFault& target);
+    void assignInput(uint32_t input, uint8_t value);
+    void scheduleFanout(uint32_t wire);
+    void implicate();
+    uint8_t evaluateGate(uint32_t gate, bool faultyMachine) const;
+    uint8_t readPin(uint32_t gate, uint8_t pin, bool faultyMachine) const;
+    bool isDetected() const;
+    bool isDFrontier(uint32_t gate) const;
+    void collectDFrontier();
+    bool hasXPath(uint32_t wire);
+    bool getObjective(uint32_t& wire, uint8_t& value);
+    bool backtrace(uint32_t wire, uint8_t value, uint32_t& input, uint8_t& inputValue) const;
+    bool isUnknown(uint32_t wire) const { return good[wire] == LogicX || faulty[wire] == LogicX; }
+
+    const CompiledNetlist& netlist;
+    size_t backtrackLimit;
+
+    std::vector<uint32_t> cc0;
+    std::vector<uint32_t> cc1;
+    std::vector<uint32_t> co;
+    // Primary input index of each wire, or NoInput.
+    std::vector<uint32_t> inputIndex;
+
+    StuckAtFault fault;
+    // Values of the good and the faulty machine (0, 1 or LogicX) with every input unassigned, and the current ones.
+    std::vector<uint8_t> initialValues;
+    std::vector<uint8_t> good;
+    std::vector<uint8_t> faulty;
+    std::vector<Decision> decisions;
+
+    // Primary outputs in the fanout cone of the current fault site, and the current D-frontier gates.
+    std::vector<uint32_t> coneOutputs;
+    std::vector<uint32_t> dFrontier;
+    std::vector<uint32_t> visitMark;
+    uint32_t visitEpoch;
+    // Wires of the fanout cone of the current fault are marked with its epoch.
+    std::vector<uint32_t> coneMark;
+    uint32_t coneEpoch;
+
+    // Pending gate evaluations of the implication, bucketed by logic level.
+    std::vector<std::vector<uint32_t>> levelQueues;
+    std::vector<uint8_t> queued;
+    std::vector<uint32_t> pathStack;
+};
@@ -0,0 +1,133 @@
+#include "RandomPatternGenerator.h"
+
+// Sequence words between two stored LFSR states.
+static const uint64_t CheckpointInterval = 1024;
+
+RandomPatternGenerator::RandomPatternGenerator()
+    : numInputs(0), mode(PRNG), seed(0), lastIndex(0), lastWord(1)
+{
+
+}
+
+// Selects the generator for 'numInputs' inputs. The same mode and seed always give the same patterns.
+void RandomPatternGenerator::configure(size_t inputs, Mode generatorMode, uint64_t generatorSeed) {
+    numInputs = inputs;
+    mode = generatorMode;
+    seed = generatorSeed;
+    // An LFSR started at zero stays at zero.
+    checkpoints.assign(1, seed != 0 ? seed : 1);
+    lastIndex = 0;
+    lastWord = checkpoints[0];
+}
+
+// Advances the LFSR by 64 clocks: returns sequence word k + 1 given word k, where bit i of word k is s[64k + i]
+// and s[n + 64] = s[n] ^ s[n + 1] ^ s[n + 3] ^ s[n + 4]. The taps reach at most 4 bits ahead, so the low bits
+// of the next word only depend on 'word' and the top bits follow from those in a second step.
+uint64_t RandomPatternGenerator::stepLfsr(uint64_t word) {
+    const uint64_t partial = word ^ (word >> 1) ^ (word >> 3) ^ (word >> 4);
+    return partial ^ (partial << 60) ^ (partial << 61) ^ (partial << 63);
+}
+
+// Fills the primary input words of the pattern block starting at pattern 'base' (a multiple of 64).
+void RandomPatternGenerator::loadBlock(const CompiledNetlist& netlist, uint64_t* values, size_t words, uint64_t base) {
+    const uint64_t firstWord = base / 64;
+    if (mode == PRNG) {
+        for (size_t j = 0; j < numInputs; ++j) {
+            for (size_t w = 0; w < words; ++w) {
+                netlist.setInputWord(values, words, j, w, getPrngWord(firstWord + w, j));
+            }
+        }
+        return;
+    }
+
+    // Input j of pattern p is s[p + j], so the block needs the sequence words up to numInputs bits past its end.
+    sequence.resize(words + numInputs / 64 + 2);
+    sequence[0] = getSequenceWord(firstWord);
+    for (size_t i = 1; i < sequence.size(); ++i) {
+        sequence[i] = stepLfsr(sequence[i - 1]);
+    }
+    for (size_t j = 0; j < numInputs; ++j) {
+        for (size_t w = 0; w < words; ++w) {
+            const size_t offset = 64 * w + j;
+            const size_t index = offset / 64;
+            const unsigned shift = static_cast<unsigned>(offset % 64);
+            const uint64_t word = shift ? (sequence[index] >> shift) | (sequence[index + 1] << (64 - shift))
+                                        : sequence[index];
+            netlist.setInputWord(values, words, j, w, word);
+        }
+    }
+}
+
+// Returns the input values of pattern 'index', as loadBlock produces them.
+std::vector<bool> RandomPatternGenerator::getPattern(uint64_t index) {
+    std::vector<bool> pattern(numInputs);
+    uint64_t sequenceIndex = index / 64;
+    uint64_t word = mode == LFSR ? getSequenceWord(sequenceIndex) : 0;
+    for (size_t j = 0; j < numInputs; ++j) {
+        if (mode == PRNG) {
+            pattern[j] = (getPrngWord(index / 64, j) >> (index % 64)) & 1;
+            continue;
+        }
+        const uint64_t bit = index + j;
+        if (bit / 64 != sequenceIndex) {
+            sequenceIndex = bit / 64;
+            word = stepLfsr(word);
+        }
+        pattern[j] = (word >> (bit % 64)) & 1;
+    }
+    return pattern;
+}
+
+// Returns LFSR sequence word 'index', starting from the last word returned or the closest stored state.
+uint64_t RandomPatternGenerator::getSequenceWord(uint64_t index) {
+    if (index < lastIndex || index - lastIndex >= CheckpointInterval) {
+        const uint64_t checkpoint = index / CheckpointInterval;
+        while (checkpoints.size() <= checkpoint) {
+            uint64_t word = checkpoints.back();
+            for (uint64_t i = 0; i < CheckpointInterval; ++i) {
+                word = stepLfsr(word);
+            }
+            checkpoints.push_back(word);
+        }
+        lastIndex = checkpoint * CheckpointInterval;
+        lastWord = checkpoints[checkpoint];
+    }
+    while (lastIndex < index) {
+        lastWord = stepLfsr(lastWord);
+        ++lastIndex;
+    }
+    return lastWord;
+}
+
+// SplitMix64 finalizer over the seed, word index and input index.
+uint64_t RandomPatternGenerator::getPrngWord(uint64_t wordIndex, size_t input) const {
+    uint64_t z = seed + wordIndex * 0x9E3779B97F4A7C15ULL + (uint64_t(input) + 1) * 0xD1B54A32D192ED03ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+Misr::Misr()
+    : state(0)
+{
+
+}
+
+void Misr::reset() {
+    state = 0;
+}
+
+// Clocks the register once per valid lane of the output words (one word per output), lowest lane first.
+void Misr::compact(const uint64_t* outputWords, size_t numOutputs, uint64_t validLanes) {
+    for (unsigned lane = 0; lane < 64 && (validLanes >> lane); ++lane) {
+        if (!((validLanes >> lane) & 1)) {
+            continue;
+        }
+        uint64_t response = 0;
+        for (size_t k = 0; k < numOutputs; ++k) {
+            response ^= ((outputWords[k] >> lane) & 1) << (k % 64);
+        }
+        const uint64_t feedback = (state ^ (state >> 1) ^ (state >> 3) ^ (state >> 4)) & 1;
+        state = ((state >> 1) | (feedback << 63)) ^ response;
+    }
+}
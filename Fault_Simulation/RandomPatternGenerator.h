@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CompiledNetlist.h"
+
+// Reproducible random input patterns, generated directly as pattern words (64 patterns per word).
+// PRNG mode hashes (seed, word, input) with a SplitMix64 finalizer, so any word can be produced on its own.
+// LFSR mode models a hardware pattern generator: a 64-stage maximal-length LFSR (x^64 + x^4 + x^3 + x + 1)
+// started at the seed, whose output sequence s feeds a scan chain, so pattern p drives input j with s[p + j].
+// The sequence is produced 64 bits per step.
+class RandomPatternGenerator {
+public:
+    enum Mode { PRNG, LFSR };
+
+    RandomPatternGenerator();
+
+    void configure(size_t numInputs, Mode mode, uint64_t seed);
+    void loadBlock(const CompiledNetlist& netlist, uint64_t* values, size_t words, uint64_t base);
+    std::vector<bool> getPattern(uint64_t index);
+
+    static uint64_t stepLfsr(uint64_t word);
+
+private:
+    uint64_t getSequenceWord(uint64_t index);
+    uint64_t getPrngWord(uint64_t wordIndex, size_t input) const;
+
+    size_t numInputs;
+    Mode mode;
+    uint64_t seed;
+    // LFSR sequence words 0, CheckpointInterval, 2 * CheckpointInterval, ... computed so far.
+    std::vector<uint64_t> checkpoints;
+    // The sequence word returned last, so that consecutive blocks continue from it.
+    uint64_t lastIndex;
+    uint64_t lastWord;
+    std::vector<uint64_t> sequence;
+};
+
+// Multiple-input signature register: compacts output responses into a 64-bit signature, one pattern per
+// clock. The register shifts with the feedback of the pattern LFSR, and output k feeds stage k mod 64.
+class Misr {
+public:
+    Misr();
+
+    void reset();
+    void compact(const uint64_t* outputWords, size_t numOutputs, uint64_t validLanes);
+    uint64_t getSignature() const { return state; }
+
+private:
+    uint64_t state;
+};
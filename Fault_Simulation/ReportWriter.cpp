@@ -0,0 +1,347 @@
+#include "ReportWriter.h"
+#include <iostream>
+#include "FaultCampaign.h"
+#include "Instrumentation.h"
+
+namespace {
+
+// A batch is handed to the writer thread once it holds this many records or bytes of names and values.
+const size_t BatchRecords = 4096;
+const size_t BatchBytes = size_t(1) << 20;
+// Batches the producer may queue ahead of the writer thread before it waits.
+const size_t MaxPendingBatches = 4;
+
+void appendNumber(std::string& out, uint64_t value) {
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (count) {
+        out.push_back(digits[--count]);
+    }
+}
+
+template <typename T>
+void appendRaw(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Appends a CSV field, quoted when the name holds a separator or a quote.
+void appendCsvField(std::string& out, const char* text, size_t length) {
+    const std::string field(text, length);
+    if (field.find_first_of(",\"\n") == std::string::npos) {
+        out += field;
+        return;
+    }
+    out.push_back('"');
+    for (char c : field) {
+        if (c == '"') {
+            out.push_back('"');
+        }
+        out.push_back(c);
+    }
+    out.push_back('"');
+}
+
+}
+
+ReportWriter::ReportWriter()
+    : file(nullptr),
+      format(TEXT),
+      writing(false),
+      stopping(false)
+{
+
+}
+
+ReportWriter::~ReportWriter() {
+    close();
+}
+
+// Opens the sink: the file at 'path' (appended to or replaced), or the console for an empty path. A CSV file
+// starts with a header row and a BINARY file with its magic, unless records are appended to a non-empty file.
+bool ReportWriter::open(const std::string& path, Format reportFormat, bool append) {
+    close();
+    format = reportFormat;
+    if (path.empty()) {
+        file = stdout;
+    } else {
+        file = std::fopen(path.c_str(), append ? "ab" : "wb");
+        if (!file) {
+            std::cerr << "Fehler beim Oeffnen der Berichtsdatei: " << path << std::endl;
+            return false;
+        }
+        setvbuf(file, nullptr, _IOFBF, BatchBytes);
+    }
+    std::fseek(file, 0, SEEK_END);
+    const bool empty = file == stdout || std::ftell(file) <= 0;
+    if (empty && format == CSV) {
+        std::fputs("record,site,stuck_at,pattern,values\n", file);
+    } else if (empty && format == BINARY) {
+        std::fwrite("FSRP\x01", 1, 5, file);
+    }
+    writer = std::thread(&ReportWriter::writerLoop, this);
+    return true;
+}
+
+// Waits until every queued record has been written and flushes the sink.
+void ReportWriter::flush() {
+    if (!file) {
+        return;
+    }
+    submitBatch();
+    std::unique_lock<std::mutex> lock(mutex);
+    batchDone.wait(lock, [this] { return pending.empty() && !writing; });
+    lock.unlock();
+    std::fflush(file);
+}
+
+// Writes the remaining records, stops the writer thread and closes the file (the console stays open).
+void ReportWriter::close() {
+    if (!file) {
+        return;
+    }
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    batchReady.notify_one();
+    writer.join();
+    stopping = false;
+    if (file != stdout) {
+        std::fclose(file);
+    }
+    file = nullptr;
+}
+
+void ReportWriter::writeFaultDetection(const std::string& site, int faultType, uint64_t firstPattern, size_t numInputs) {
+    Record& record = addRecord(FAULT_DETECTION, site, faultType, firstPattern);
+    record.numInputs = static_cast<uint32_t>(numInputs);
+    if (firstPattern != FaultGrade::NotDetected) {
+        for (size_t j = 0; j < numInputs; ++j) {
+            current.data.push_back(static_cast<char>((firstPattern >> j) & 1));
+        }
+        record.valueCount = static_cast<uint32_t>(numInputs);
+    }
+    if (current.records.size() >= BatchRecords || current.data.size() >= BatchBytes) {
+        submitBatch();
+    }
+}
+
+void ReportWriter::writeSampledFaultDetection(const std::string& site, int faultType, uint64_t firstPattern,
+                                              const std::vector<bool>* inputValues) {
+    Record& record = addRecord(SAMPLED_FAULT_DETECTION, site, faultType, firstPattern);
+    if (inputValues) {
+        for (bool value : *inputValues) {
+            current.data.push_back(static_cast<char>(value));
+        }
+        record.numInputs = static_cast<uint32_t>(inputValues->size());
+        record.valueCount = record.numInputs;
+    }
+    if (current.records.size() >= BatchRecords || current.data.size() >= BatchBytes) {
+        submitBatch();
+    }
+}
+
+void ReportWriter::writeUndetectedFault(const std::string& site, int faultType) {
+    addRecord(UNDETECTED_FAULT, site, faultType, FaultGrade::NotDetected);
+    if (current.records.size() >= BatchRecords || current.data.size() >= BatchBytes) {
+        submitBatch();
+    }
+}
+
+void ReportWriter::writeGoodResponse(uint64_t pattern, size_t numInputs, const std::vector<bool>& outputValues) {
+    Record& record = addRecord(GOOD_RESPONSE, std::string(), 0, pattern);
+    record.numInputs = static_cast<uint32_t>(numInputs);
+    for (bool value : outputValues) {
+        current.data.push_back(static_cast<char>(value));
+    }
+    record.valueCount = static_cast<uint32_t>(outputValues.size());
+    if (current.records.size() >= BatchRecords || current.data.size() >= BatchBytes) {
+        submitBatch();
+    }
+}
+
+// Appends a record with its site name to the current batch; the caller appends the values right behind it.
+ReportWriter::Record& ReportWriter::addRecord(RecordKind kind, const std::string& site, int faultType, uint64_t pattern) {
+    Record record;
+    record.pattern = pattern;
+    record.numInputs = 0;
+    record.siteOffset = static_cast<uint32_t>(current.data.size());
+    record.siteLength = static_cast<uint32_t>(site.size());
+    record.valueCount = 0;
+    record.kind = kind;
+    record.faultType = static_cast<uint8_t>(faultType);
+    current.data += site;
+    current.records.push_back(record);
+    return current.records.back();
+}
+
+// Hands the current batch to the writer thread, waiting while it is too far behind.
+void ReportWriter::submitBatch() {
+    if (current.records.empty()) {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        batchDone.wait(lock, [this] { return pending.size() < MaxPendingBatches; });
+        pending.push_back(std::move(current));
+    }
+    batchReady.notify_one();
+    current = Batch();
+    current.records.reserve(BatchRecords);
+}
+
+// Formats and writes the queued batches in order until the writer is closed.
+void ReportWriter::writerLoop() {
+    std::string out;
+    for (;;) {
+        Batch batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            batchReady.wait(lock, [this] { return !pending.empty() || stopping; });
+            if (pending.empty()) {
+                return;
+            }
+            batch = std::move(pending.front());
+            pending.pop_front();
+            writing = true;
+        }
+        out.clear();
+        formatBatch(batch, out);
+        std::fwrite(out.data(), 1, out.size(), file);
+        INSTRUMENT_COUNT(BYTES_WRITTEN, out.size());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            writing = false;
+        }
+        batchDone.notify_all();
+    }
+}
+
+void ReportWriter::formatBatch(const Batch& batch, std::string& out) const {
+    for (const Record& record : batch.records) {
+        switch (format) {
+            case CSV:
+                formatCsv(batch, record, out);
+                break;
+            case BINARY:
+                formatBinary(batch, record, out);
+                break;
+            default:
+                formatText(batch, record, out);
+                break;
+        }
+    }
+}
+
+// The lines of the original console and file reports.
+void ReportWriter::formatText(const Batch& batch, const Record& record, std::string& out) const {
+    const char* site = batch.data.data() + record.siteOffset;
+    const char* values = site + record.siteLength;
+    const bool detected = record.pattern != FaultGrade::NotDetected;
+    switch (record.kind) {
+        case FAULT_DETECTION:
+            out += detected ? "\\" : "No fault detected on wire \\";
+            out.append(site, record.siteLength);
+            out += " stuck-at-";
+            appendNumber(out, record.faultType);
+            if (detected) {
+                out += " with inputs: ";
+                for (uint32_t j = 0; j < record.valueCount; ++j) {
+                    out.push_back(values[j] ? '1' : '0');
+                    if (j < record.valueCount - 1) {
+                        out += ", ";
+                    }
+                }
+            }
+            out.push_back('\n');
+            break;
+        case SAMPLED_FAULT_DETECTION:
+            if (!detected) {
+                out += "No fault detected on wire ";
+            }
+            out.append(site, record.siteLength);
+            out += " stuck-at-";
+            appendNumber(out, record.faultType);
+            if (detected) {
+                out += " with inputs: ";
+                for (uint32_t j = 0; j < record.valueCount; ++j) {
+                    out.push_back(values[j] ? '1' : '0');
+                    if (j < record.valueCount - 1) {
+                        out += ", ";
+                    }
+                }
+                out += " leads to different outputs";
+            }
+            out += ".\n";
+            break;
+        case UNDETECTED_FAULT:
+            out += "Fault was undetected for ";
+            out.append(site, record.siteLength);
+            out += " stuck-at-";
+            appendNumber(out, record.faultType);
+            out.push_back('\n');
+            break;
+        case GOOD_RESPONSE:
+            out += "inputs: ";
+            for (uint32_t j = 0; j < record.numInputs; ++j) {
+                out.push_back((record.pattern >> j) & 1 ? '1' : '0');
+                out.push_back(j < record.numInputs - 1 ? ',' : ' ');
+            }
+            out += "gives outputs: ";
+            for (uint32_t k = 0; k < record.valueCount; ++k) {
+                out.push_back(values[k] ? '1' : '0');
+                out.push_back(k < record.valueCount - 1 ? ',' : '\n');
+            }
+            break;
+    }
+}
+
+// One row per record: record kind, site, stuck-at value, pattern (empty if undetected) and the values as a bit
+// string (the detecting input values, or the good outputs).
+void ReportWriter::formatCsv(const Batch& batch, const Record& record, std::string& out) const {
+    static const char* const kindNames[] = { "fault", "fault", "undetected", "response" };
+    const char* site = batch.data.data() + record.siteOffset;
+    const char* values = site + record.siteLength;
+    out += kindNames[record.kind];
+    out.push_back(',');
+    appendCsvField(out, site, record.siteLength);
+    out.push_back(',');
+    if (record.kind != GOOD_RESPONSE) {
+        appendNumber(out, record.faultType);
+    }
+    out.push_back(',');
+    if (record.pattern != FaultGrade::NotDetected) {
+        appendNumber(out, record.pattern);
+    }
+    out.push_back(',');
+    for (uint32_t j = 0; j < record.valueCount; ++j) {
+        out.push_back(values[j] ? '1' : '0');
+    }
+    out.push_back('\n');
+}
+
+// kind (1 byte), stuck-at value (1), pattern (8, all ones if undetected), input count (4), site length (4) and
+// name, value count (4) and the values packed 8 per byte, lowest bit first.
+void ReportWriter::formatBinary(const Batch& batch, const Record& record, std::string& out) const {
+    const char* site = batch.data.data() + record.siteOffset;
+    const char* values = site + record.siteLength;
+    appendRaw(out, static_cast<uint8_t>(record.kind));
+    appendRaw(out, record.faultType);
+    appendRaw(out, record.pattern);
+    appendRaw(out, record.numInputs);
+    appendRaw(out, record.siteLength);
+    out.append(site, record.siteLength);
+    appendRaw(out, record.valueCount);
+    for (uint32_t j = 0; j < record.valueCount; j += 8) {
+        uint8_t packed = 0;
+        for (uint32_t b = 0; b < 8 && j + b < record.valueCount; ++b) {
+            packed |= static_cast<uint8_t>(values[j + b] ? 1 : 0) << b;
+        }
+        appendRaw(out, packed);
+    }
+}
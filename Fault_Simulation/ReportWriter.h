@@ -0,0 +1,80 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A report sink that stays open for a whole run. Callers queue compact records (fault detections and good
+// responses); a background thread formats them in batches and hands each batch to the file in one large write,
+// so formatting and I/O overlap with the simulation instead of costing a stream operation per value.
+// TEXT reproduces the console and file lines of the original reports, CSV writes one row per record, and BINARY
+// writes length-prefixed records in host byte order behind the magic "FSRP".
+// The sink is the console when opened with an empty path; flush() must be called before other console output.
+class ReportWriter {
+public:
+    enum Format { TEXT, CSV, BINARY };
+
+    ReportWriter();
+    ~ReportWriter();
+
+    bool open(const std::string& path, Format format, bool append = false);
+    bool isOpen() const { return file != nullptr; }
+    void flush();
+    void close();
+
+    // First detecting pattern of a fault under exhaustive patterns, whose input values are the pattern's bits.
+    void writeFaultDetection(const std::string& site, int faultType, uint64_t firstPattern, size_t numInputs);
+    // First detecting pattern of a fault under sampled patterns, with the input values of that pattern.
+    void writeSampledFaultDetection(const std::string& site, int faultType, uint64_t firstPattern,
+                                    const std::vector<bool>* inputValues);
+    void writeUndetectedFault(const std::string& site, int faultType);
+    // Output values of the good machine under exhaustive pattern 'pattern'.
+    void writeGoodResponse(uint64_t pattern, size_t numInputs, const std::vector<bool>& outputValues);
+
+private:
+    enum RecordKind : uint8_t { FAULT_DETECTION, SAMPLED_FAULT_DETECTION, UNDETECTED_FAULT, GOOD_RESPONSE };
+
+    // A queued record; its site name and values (one byte per value) live in the batch's data buffer.
+    struct Record {
+        uint64_t pattern;
+        uint32_t numInputs;
+        uint32_t siteOffset;
+        uint32_t siteLength;
+        uint32_t valueCount;
+        RecordKind kind;
+        uint8_t faultType;
+    };
+    struct Batch {
+        std::vector<Record> records;
+        std::string data;
+    };
+
+    ReportWriter(const ReportWriter&);
+    ReportWriter& operator=(const ReportWriter&);
+
+    Record& addRecord(RecordKind kind, const std::string& site, int faultType, uint64_t pattern);
+    void submitBatch();
+    void writerLoop();
+    void formatBatch(const Batch& batch, std::string& out) const;
+    void formatText(const Batch& batch, const Record& record, std::string& out) const;
+    void formatCsv(const Batch& batch, const Record& record, std::string& out) const;
+    void formatBinary(const Batch& batch, const Record& record, std::string& out) const;
+
+    std::FILE* file;
+    Format format;
+    Batch current;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable batchReady;
+    std::condition_variable batchDone;
+    // Batches waiting for the writer thread; 'writing' while it formats and writes one.
+    std::deque<Batch> pending;
+    bool writing;
+    bool stopping;
+};
@@ -0,0 +1,71 @@
+#include "ResultStore.h"
+#include <algorithm>
+#include <iostream>
+#include "PatternKernels.h"
+
+ResultStore::ResultStore()
+    : numPatterns(0), numOutputs(0), words(nullptr)
+{
+
+}
+
+// Sizes the store for 'numPatterns' responses of 'numOutputs' outputs, all zero. With a backing file the words
+// are kept in that file (created or overwritten) instead of the heap; returns false if it cannot be mapped.
+bool ResultStore::allocate(size_t patterns, size_t outputs, const std::string& backingFile) {
+    numPatterns = patterns;
+    numOutputs = outputs;
+    const size_t numWordsTotal = getNumWords() * numOutputs;
+    memory.clear();
+    file.reset();
+    if (!backingFile.empty()) {
+        file.reset(new MappedFile());
+        if (!file->create(backingFile, numWordsTotal * sizeof(uint64_t))) {
+            std::cerr << "Fehler beim Anlegen der Ergebnisdatei: " << backingFile << std::endl;
+            file.reset();
+            numPatterns = 0;
+            numOutputs = 0;
+            words = nullptr;
+            return false;
+        }
+        // A new file reads as zeros, like the heap store.
+        words = reinterpret_cast<uint64_t*>(file->writableData());
+        return true;
+    }
+    memory.assign(numWordsTotal, 0);
+    words = memory.data();
+    return true;
+}
+
+void ResultStore::set(size_t pattern, size_t output, bool value) {
+    uint64_t& word = getWord(pattern / 64)[output];
+    const uint64_t lane = uint64_t(1) << (pattern % 64);
+    word = value ? (word | lane) : (word & ~lane);
+}
+
+// Returns the lanes of word 'wordIndex' in which any output of 'outputWords' (one word per output) differs from
+// the stored responses. Lanes beyond the last pattern are never reported.
+uint64_t ResultStore::compareWord(size_t wordIndex, const uint64_t* outputWords) const {
+    const uint64_t* stored = getWord(wordIndex);
+    uint64_t difference = 0;
+    for (size_t k = 0; k < numOutputs; ++k) {
+        difference |= stored[k] ^ outputWords[k];
+    }
+    return difference & validLaneMask(numPatterns, wordIndex);
+}
+
+// Returns the first pattern whose responses differ between the two stores, or ~0 if they are equal
+// over the patterns both hold.
+uint64_t ResultStore::findFirstDifference(const ResultStore& other) const {
+    const size_t patterns = std::min(numPatterns, other.numPatterns);
+    if (numOutputs != other.numOutputs) {
+        return patterns ? 0 : ~uint64_t(0);
+    }
+    const size_t numWordsCompared = (patterns + 63) / 64;
+    for (size_t w = 0; w < numWordsCompared; ++w) {
+        const uint64_t difference = compareWord(w, other.getWord(w)) & validLaneMask(patterns, w);
+        if (difference) {
+            return 64 * w + lowestSetLane(difference);
+        }
+    }
+    return ~uint64_t(0);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// Output responses of a pattern sweep as a packed bitset, 64 patterns per word.
+// Word w holds patterns 64 * w .. 64 * w + 63 and is stored as one 64-bit word per primary output
+// (getWord(w)[k] is output k), so a response block compares against a simulated block with a few XORs
+// instead of per-pattern vectors. The words live in memory or, for huge sweeps, in a memory-mapped file.
+class ResultStore {
+public:
+    ResultStore();
+
+    bool allocate(size_t numPatterns, size_t numOutputs, const std::string& backingFile = std::string());
+
+    size_t getNumPatterns() const { return numPatterns; }
+    size_t getNumOutputs() const { return numOutputs; }
+    size_t getNumWords() const { return (numPatterns + 63) / 64; }
+
+    uint64_t* getWord(size_t wordIndex) { return words + wordIndex * numOutputs; }
+    const uint64_t* getWord(size_t wordIndex) const { return words + wordIndex * numOutputs; }
+    bool get(size_t pattern, size_t output) const {
+        return (getWord(pattern / 64)[output] >> (pattern % 64)) & 1;
+    }
+    void set(size_t pattern, size_t output, bool value);
+
+    uint64_t compareWord(size_t wordIndex, const uint64_t* outputWords) const;
+    uint64_t findFirstDifference(const ResultStore& other) const;
+
+private:
+    size_t numPatterns;
+    size_t numOutputs;
+    uint64_t* words;
+    std::vector<uint64_t> memory;
+    std::unique_ptr<MappedFile> file;
+};
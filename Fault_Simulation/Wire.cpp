@@ -3,7 +3,10 @@
 // Constructor for the Wire class that initializes a wire with a given name.
 Wire::Wire(const std::string& name) 
     : name(name), // Set the name of the wire, which is useful for identification purposes.
-      value(false) // Initialize the wire's value to false (0) by default.
+      value(false), // Initialize the wire's value to false (0) by default.
+      id(0), // The circuit assigns the actual id when the wire is added.
+      driver(nullptr), // No gate drives the wire until one is added to the circuit.
+      faultValue(false)
 {
     
 }
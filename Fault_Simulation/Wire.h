@@ -1,5 +1,9 @@
 ﻿#pragma once
+#include <cstdint>
 #include <string>
+#include <vector>
+
+class Gate;
 
 class Wire {
 public:
@@ -8,15 +12,30 @@ public:
     
     bool getValue() const;
     void setValue(bool val);
-    
+
     const std::string& getName() const;
+
+    // Dense index of the wire within its circuit, used by the compiled netlist.
+    uint32_t getId() const { return id; }
+    void setId(uint32_t newId) { id = newId; }
+
+    // Driver/fanout index, maintained by the circuit as gates are added.
+    Gate* getDriver() const { return driver; }
+    void setDriver(Gate* gate) { driver = gate; }
+    const std::vector<Gate*>& getFanout() const { return fanout; }
+    void addFanout(Gate* gate) { fanout.push_back(gate); }
     
     void setFault(bool isFaulted, bool faultValue);
     void clearFault();
+    bool hasFault() const { return isFaulted; }
+    bool getFaultValue() const { return faultValue; }
     
 private:
     std::string name;
     bool value;
+    uint32_t id;
+    Gate* driver;
+    std::vector<Gate*> fanout;
     bool isFaulted = false;
     bool faultValue;
 };
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "WorkStealingScheduler.h"
+
+WorkStealingScheduler::WorkStealingScheduler(size_t numWorkers)
+    : currentTask(nullptr),
+      generation(0),
+      busyWorkers(0),
+      stopping(false)
+{
+    if (numWorkers == 0) {
+        numWorkers = 1;
+    }
+    for (size_t i = 0; i < numWorkers; ++i) {
+        queues.emplace_back(new ChunkRange());
+    }
+    for (size_t i = 1; i < numWorkers; ++i) {
+        threads.emplace_back(&WorkStealingScheduler::workerLoop, this, i);
+    }
+}
+
+WorkStealingScheduler::~WorkStealingScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    startCondition.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+// Runs task(worker, chunk) once for every chunk in 0 .. numChunks-1 and returns when all of them are done.
+// Chunks run concurrently in no particular order, so the task must only write state owned by its chunk or
+// its worker.
+void WorkStealingScheduler::run(size_t numChunks, const Task& task) {
+    const size_t numWorkers = queues.size();
+    for (size_t i = 0; i < numWorkers; ++i) {
+        std::lock_guard<std::mutex> lock(queues[i]->mutex);
+        queues[i]->begin = numChunks * i / numWorkers;
+        queues[i]->end = numChunks * (i + 1) / numWorkers;
+    }
+    if (numWorkers == 1) {
+        for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+            task(0, chunk);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        currentTask = &task;
+        busyWorkers = numWorkers - 1;
+        ++generation;
+    }
+    startCondition.notify_all();
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(stateMutex);
+    doneCondition.wait(lock, [this] { return busyWorkers == 0; });
+    currentTask = nullptr;
+}
+
+void WorkStealingScheduler::workerLoop(size_t worker) {
+    uint64_t seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            startCondition.wait(lock, [this, seenGeneration] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+        drain(worker);
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            --busyWorkers;
+        }
+        doneCondition.notify_one();
+    }
+}
+
+// Processes the worker's own chunks, then steals until no other worker has chunks left.
+void WorkStealingScheduler::drain(size_t worker) {
+    size_t chunk;
+    do {
+        while (takeOwnChunk(worker, chunk)) {
+            (*currentTask)(worker, chunk);
+        }
+    } while (stealChunks(worker));
+}
+
+bool WorkStealingScheduler::takeOwnChunk(size_t worker, size_t& chunk) {
+    ChunkRange& own = *queues[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (own.begin == own.end) {
+        return false;
+    }
+    chunk = own.begin++;
+    return true;
+}
+
+// Moves the back half of the largest other range into the worker's own (empty) range.
+bool WorkStealingScheduler::stealChunks(size_t worker) {
+    const size_t numWorkers = queues.size();
+    for (;;) {
+        size_t victim = worker;
+        size_t largest = 0;
+        for (size_t i = 1; i < numWorkers; ++i) {
+            const size_t candidate = (worker + i) % numWorkers;
+            std::lock_guard<std::mutex> lock(queues[candidate]->mutex);
+            const size_t size = queues[candidate]->end - queues[candidate]->begin;
+            if (size > largest) {
+                largest = size;
+                victim = candidate;
+            }
+        }
+        if (victim == worker) {
+            return false;
+        }
+
+        size_t begin;
+        size_t end;
+        {
+            ChunkRange& range = *queues[victim];
+            std::lock_guard<std::mutex> lock(range.mutex);
+            const size_t size = range.end - range.begin;
+            if (size == 0) {
+                // Another thief or the owner emptied it in the meantime; look again.
+                continue;
+            }
+            end = range.end;
+            begin = end - (size + 1) / 2;
+            range.end = begin;
+        }
+        ChunkRange& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = begin;
+        own.end = end;
+        return true;
+    }
+}
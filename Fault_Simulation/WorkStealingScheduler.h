@@ -0,0 +1,49 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed pool of worker threads that process numbered work chunks with work stealing.
+// Every run hands each worker a contiguous range of chunks. A worker takes chunks from the front of its own
+// range; once that is empty it steals the back half of the fullest other range, so a few expensive chunks
+// never leave the other workers idle. The calling thread acts as worker 0, and the threads are kept
+// between runs.
+class WorkStealingScheduler {
+public:
+    typedef std::function<void(size_t worker, size_t chunk)> Task;
+
+    explicit WorkStealingScheduler(size_t numWorkers);
+    ~WorkStealingScheduler();
+
+    size_t getNumWorkers() const { return queues.size(); }
+    void run(size_t numChunks, const Task& task);
+
+private:
+    // The chunks [begin, end) a worker still owns.
+    struct ChunkRange {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    void workerLoop(size_t worker);
+    void drain(size_t worker);
+    bool takeOwnChunk(size_t worker, size_t& chunk);
+    bool stealChunks(size_t worker);
+
+    std::vector<std::unique_ptr<ChunkRange>> queues;
+    std::vector<std::thread> threads;
+    const Task* currentTask;
+
+    std::mutex stateMutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+    uint64_t generation;
+    size_t busyWorkers;
+    bool stopping;
+};